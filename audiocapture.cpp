@@ -0,0 +1,422 @@
+#include "audiocapture.h"
+#include <QString>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+AudioCapture::AudioCapture(QObject *parent)
+    : QObject(parent)
+    , captureHandle(nullptr)
+    , actualRate(0)
+    , actualChannels(1)
+    , frameSize(0)
+    , mmapAccess(false)
+    , wakeFd(-1)
+    , running(false)
+    , stopRequested(false)
+    , notifyPending(false)
+    , framesCaptured(0)
+    , framesDropped(0)
+    , xruns(0)
+    , peakFill(0)
+{
+}
+
+AudioCapture::~AudioCapture()
+{
+    stop();
+}
+
+bool AudioCapture::start(const CaptureOptions& opts)
+{
+    if (running) return true;
+    // Поток мог завершиться сам после ошибки чтения — освобождаем его ресурсы
+    stop();
+
+    options = opts;
+    int err;
+
+    const bool pollMode = options.mode == CaptureMode::Poll;
+    if ((err = snd_pcm_open(&captureHandle, options.device.c_str(), SND_PCM_STREAM_CAPTURE,
+                            pollMode ? SND_PCM_NONBLOCK : 0)) < 0) {
+        emit logMessage(QString("Ошибка открытия аудио устройства: %1").arg(snd_strerror(err)));
+        captureHandle = nullptr;
+        return false;
+    }
+
+    unsigned int rate = options.sampleRate;
+    unsigned int channels = options.channels;
+    snd_pcm_uframes_t period = options.sampleRate * options.frameMs / 1000;
+    snd_pcm_uframes_t bufferFrames = period * 8;
+
+    snd_pcm_hw_params_t *hw_params = nullptr;
+    snd_pcm_hw_params_alloca(&hw_params);
+    snd_pcm_hw_params_any(captureHandle, hw_params);
+
+    mmapAccess = false;
+    if (options.access == CaptureAccess::Mmap) {
+        if (snd_pcm_hw_params_set_access(captureHandle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0) {
+            mmapAccess = true;
+        } else {
+            emit logMessage("Устройство не поддерживает mmap, используется чтение через snd_pcm_readi");
+        }
+    }
+    if (!mmapAccess) {
+        snd_pcm_hw_params_set_access(captureHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    snd_pcm_hw_params_set_format(captureHandle, hw_params, SND_PCM_FORMAT_S16_LE);
+    snd_pcm_hw_params_set_rate_near(captureHandle, hw_params, &rate, nullptr);
+    // Многие USB микрофоны умеют только стерео — берём ближайшее, сведение в моно сделает ресемплер
+    snd_pcm_hw_params_set_channels_near(captureHandle, hw_params, &channels);
+    snd_pcm_hw_params_set_period_size_near(captureHandle, hw_params, &period, nullptr);
+    snd_pcm_hw_params_set_buffer_size_near(captureHandle, hw_params, &bufferFrames);
+
+    if ((err = snd_pcm_hw_params(captureHandle, hw_params)) < 0) {
+        emit logMessage(QString("Ошибка настройки аудио параметров: %1").arg(snd_strerror(err)));
+        closeDevice();
+        return false;
+    }
+
+    snd_pcm_hw_params_get_period_size(hw_params, &period, nullptr);
+    snd_pcm_hw_params_get_rate(hw_params, &rate, nullptr);
+    snd_pcm_hw_params_get_channels(hw_params, &channels);
+
+    if (pollMode) {
+        // Устройство будит poll() только когда накоплен целый период
+        snd_pcm_sw_params_t *sw_params = nullptr;
+        snd_pcm_sw_params_alloca(&sw_params);
+        snd_pcm_sw_params_current(captureHandle, sw_params);
+        snd_pcm_sw_params_set_avail_min(captureHandle, sw_params, period);
+        if ((err = snd_pcm_sw_params(captureHandle, sw_params)) < 0) {
+            emit logMessage(QString("Ошибка настройки программных параметров ALSA: %1").arg(snd_strerror(err)));
+            closeDevice();
+            return false;
+        }
+
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            emit logMessage(QString("Не удалось создать eventfd: %1").arg(strerror(errno)));
+            closeDevice();
+            return false;
+        }
+    }
+
+    actualRate = rate;
+    actualChannels = channels;
+    // Кадр равен периоду устройства: каждое пробуждение даёт целое число кадров
+    frameSize = period;
+    // Промежуточный буфер нужен только для snd_pcm_readi
+    frameBuffer.assign(mmapAccess ? 0 : frameSize * actualChannels, 0);
+    ring = std::make_unique<SpscRingBuffer<short>>(
+        static_cast<size_t>(actualRate) * actualChannels * options.ringMs / 1000);
+
+    framesCaptured = 0;
+    framesDropped = 0;
+    xruns = 0;
+    peakFill = 0;
+    notifyPending = false;
+
+    emit logMessage(QString("Аудио устройство инициализировано: %1 Гц, каналов %2, период %3 кадров, режим %4, доступ %5")
+                    .arg(actualRate).arg(actualChannels).arg(static_cast<unsigned long>(period))
+                    .arg(pollMode ? "poll" : "blocking")
+                    .arg(mmapAccess ? "mmap" : "rw"));
+
+    stopRequested = false;
+    running = true;
+    captureThread = std::thread(&AudioCapture::captureLoop, this);
+    return true;
+}
+
+void AudioCapture::stop()
+{
+    stopRequested = true;
+    running = false;
+    // В режиме poll будим поток через eventfd,
+    // блокирующее чтение вернётся не позже чем через один период
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+    if (captureThread.joinable()) {
+        captureThread.join();
+    }
+    closeDevice();
+}
+
+void AudioCapture::closeDevice()
+{
+    if (captureHandle) {
+        snd_pcm_close(captureHandle);
+        captureHandle = nullptr;
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+}
+
+CaptureStats AudioCapture::stats() const
+{
+    CaptureStats s;
+    s.framesCaptured = framesCaptured.load(std::memory_order_relaxed);
+    s.framesDropped = framesDropped.load(std::memory_order_relaxed);
+    s.xruns = xruns.load(std::memory_order_relaxed);
+    s.peakFillSamples = peakFill.load(std::memory_order_relaxed);
+    if (ring) {
+        s.fillSamples = ring->readAvailable();
+        s.capacitySamples = ring->capacity();
+    }
+    return s;
+}
+
+void AudioCapture::applyThreadPolicy()
+{
+    if (options.cpuCore >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(options.cpuCore, &cpuset);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (err != 0) {
+            emit logMessage(QString("Не удалось привязать поток захвата к ядру %1: %2")
+                            .arg(options.cpuCore).arg(strerror(err)));
+        }
+    }
+
+    if (options.realtimePriority > 0) {
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = options.realtimePriority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            // Без CAP_SYS_NICE / rtprio в limits.conf остаёмся на обычном планировщике
+            emit logMessage(QString("Не удалось включить SCHED_FIFO (приоритет %1): %2")
+                            .arg(options.realtimePriority).arg(strerror(err)));
+        }
+    }
+}
+
+void AudioCapture::captureLoop()
+{
+    applyThreadPolicy();
+
+    if (options.mode == CaptureMode::Poll) {
+        pollLoop();
+    } else {
+        blockingLoop();
+    }
+
+    // Без остановки цикл выходит только после неустранимой ошибки — иначе кадры просто перестают приходить
+    if (!stopRequested.load(std::memory_order_acquire)) {
+        running = false;
+        emit captureFailed();
+    }
+}
+
+bool AudioCapture::pushSamples(const short* data, size_t count)
+{
+    if (!ring->push(data, count)) {
+        framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AudioCapture::updatePeakFill()
+{
+    size_t fill = ring->readAvailable();
+    if (fill > peakFill.load(std::memory_order_relaxed)) {
+        peakFill.store(fill, std::memory_order_relaxed);
+    }
+}
+
+// Забирает из устройства один период и кладёт его в кольцевой буфер.
+// Возвращает число прочитанных кадров или код ошибки ALSA.
+snd_pcm_sframes_t AudioCapture::readPeriod()
+{
+    if (mmapAccess) {
+        return readPeriodMmap();
+    }
+
+    snd_pcm_sframes_t frames = snd_pcm_readi(captureHandle, frameBuffer.data(), frameSize);
+    if (frames > 0) {
+        framesCaptured.fetch_add(1, std::memory_order_relaxed);
+        pushSamples(frameBuffer.data(), static_cast<size_t>(frames) * actualChannels);
+        updatePeakFill();
+    }
+    return frames;
+}
+
+// Копирует период прямо из области mmap в кольцевой буфер — единственная копия
+// между драйвером и распознавателем, который читает кольцевой буфер на месте.
+snd_pcm_sframes_t AudioCapture::readPeriodMmap()
+{
+    snd_pcm_uframes_t remaining = frameSize;
+    while (remaining > 0) {
+        const snd_pcm_channel_area_t *areas = nullptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t frames = remaining;
+        int err = snd_pcm_mmap_begin(captureHandle, &areas, &offset, &frames);
+        if (err < 0) {
+            return err;
+        }
+
+        // S16 с чередованием: first и step заданы в битах, каналы кадра лежат подряд
+        const short* src = reinterpret_cast<const short*>(
+            static_cast<const char*>(areas[0].addr) + areas[0].first / 8 + offset * (areas[0].step / 8));
+        pushSamples(src, frames * actualChannels);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(captureHandle, offset, frames);
+        if (committed < 0) {
+            return committed;
+        }
+        if (static_cast<snd_pcm_uframes_t>(committed) != frames) {
+            return -EPIPE;
+        }
+        remaining -= frames;
+    }
+
+    framesCaptured.fetch_add(1, std::memory_order_relaxed);
+    updatePeakFill();
+    return static_cast<snd_pcm_sframes_t>(frameSize);
+}
+
+void AudioCapture::notifyConsumer()
+{
+    if (!notifyPending.exchange(true, std::memory_order_acq_rel)) {
+        emit framesAvailable();
+    }
+}
+
+bool AudioCapture::recoverDevice(int err)
+{
+    if (err == -EAGAIN) {
+        return true;
+    }
+    if (err == -EPIPE) {
+        xruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    err = snd_pcm_recover(captureHandle, err, 1);
+    if (err < 0) {
+        emit logMessage(QString("Ошибка чтения аудио: %1").arg(snd_strerror(err)));
+        running = false;
+        return false;
+    }
+    if (options.mode == CaptureMode::Poll || mmapAccess) {
+        // После восстановления поток в состоянии PREPARED и сам не стартует
+        snd_pcm_start(captureHandle);
+    }
+    return true;
+}
+
+void AudioCapture::blockingLoop()
+{
+    if (mmapAccess) {
+        // В режиме mmap поток не запускается сам при первом чтении
+        int err = snd_pcm_start(captureHandle);
+        if (err < 0 && !recoverDevice(err)) {
+            return;
+        }
+    }
+
+    while (running.load(std::memory_order_acquire)) {
+        if (mmapAccess) {
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(captureHandle);
+            if (avail < 0) {
+                if (!recoverDevice(static_cast<int>(avail))) break;
+                continue;
+            }
+            if (avail < static_cast<snd_pcm_sframes_t>(frameSize)) {
+                // Ограниченное ожидание, чтобы заметить остановку
+                int err = snd_pcm_wait(captureHandle, 100);
+                if (err < 0 && !recoverDevice(err)) break;
+                continue;
+            }
+        }
+
+        snd_pcm_sframes_t frames = readPeriod();
+        if (frames < 0) {
+            if (!recoverDevice(static_cast<int>(frames))) break;
+            continue;
+        }
+        if (frames > 0) {
+            notifyConsumer();
+        }
+    }
+}
+
+void AudioCapture::pollLoop()
+{
+    int count = snd_pcm_poll_descriptors_count(captureHandle);
+    if (count <= 0) {
+        emit logMessage("Устройство не предоставляет дескрипторы для poll()");
+        running = false;
+        return;
+    }
+
+    // Последний дескриптор — eventfd остановки
+    std::vector<struct pollfd> fds(static_cast<size_t>(count) + 1);
+    snd_pcm_poll_descriptors(captureHandle, fds.data(), static_cast<unsigned int>(count));
+    fds[count].fd = wakeFd;
+    fds[count].events = POLLIN;
+
+    int err = snd_pcm_start(captureHandle);
+    if (err < 0 && !recoverDevice(err)) {
+        return;
+    }
+
+    while (running.load(std::memory_order_acquire)) {
+        for (auto& fd : fds) {
+            fd.revents = 0;
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            emit logMessage(QString("Ошибка poll(): %1").arg(strerror(errno)));
+            running = false;
+            break;
+        }
+        if (fds[count].revents & POLLIN) {
+            break;
+        }
+
+        unsigned short revents = 0;
+        snd_pcm_poll_descriptors_revents(captureHandle, fds.data(), static_cast<unsigned int>(count), &revents);
+        if (revents & POLLERR) {
+            if (!recoverDevice(-EPIPE)) break;
+            continue;
+        }
+        if (!(revents & POLLIN)) {
+            continue;
+        }
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(captureHandle);
+        if (avail < 0) {
+            if (!recoverDevice(static_cast<int>(avail))) break;
+            continue;
+        }
+
+        // Читаем только целые периоды, остаток дождётся следующего пробуждения
+        bool pushed = false;
+        while (avail >= static_cast<snd_pcm_sframes_t>(frameSize)) {
+            snd_pcm_sframes_t frames = readPeriod();
+            if (frames < 0) {
+                if (!recoverDevice(static_cast<int>(frames))) return;
+                break;
+            }
+            if (frames == 0) {
+                break;
+            }
+            pushed = true;
+            avail -= frames;
+        }
+
+        // Одно уведомление на пробуждение, а не на каждый период
+        if (pushed) {
+            notifyConsumer();
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef AUDIOCAPTURE_H
+#define AUDIOCAPTURE_H
+
+#include <QObject>
+#include <alsa/asoundlib.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ringbuffer.h"
+
+// Способ ожидания данных от устройства
+enum class CaptureMode {
+    Blocking,   // Блокирующий snd_pcm_readi
+    Poll        // poll() по дескрипторам ALSA, чтение ровно тогда, когда готов период
+};
+
+// Способ доступа к буферу устройства
+enum class CaptureAccess {
+    ReadWrite,  // snd_pcm_readi с копией в промежуточный буфер
+    Mmap        // Чтение прямо из области mmap устройства (при отсутствии поддержки — ReadWrite)
+};
+
+// Параметры захвата звука
+struct CaptureOptions {
+    std::string device = "default";
+    CaptureMode mode = CaptureMode::Poll;
+    CaptureAccess access = CaptureAccess::Mmap;
+    unsigned int sampleRate = 16000;   // Желаемая частота; фактическую выбирает устройство
+    unsigned int channels = 1;
+    unsigned int frameMs = 20;      // Желаемый период ALSA; кадр в кольцевом буфере равен фактическому периоду
+    unsigned int ringMs = 2000;     // Ёмкость кольцевого буфера
+    int realtimePriority = 0;       // Приоритет SCHED_FIFO (0 — обычный планировщик)
+    int cpuCore = -1;               // Ядро для привязки потока захвата (-1 — без привязки)
+};
+
+// Счётчики захвата (снимок)
+struct CaptureStats {
+    uint64_t framesCaptured = 0;
+    uint64_t framesDropped = 0;     // Кадры, не поместившиеся в кольцевой буфер (распознавание не успевает)
+    uint64_t xruns = 0;             // Переполнения буфера ALSA
+    size_t fillSamples = 0;
+    size_t peakFillSamples = 0;
+    size_t capacitySamples = 0;
+};
+
+// Захват звука в отдельном потоке.
+// Поток читает ALSA кадрами фиксированного размера и складывает их в кольцевой буфер,
+// поток распознавания забирает данные через peek()/consume().
+class AudioCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioCapture(QObject *parent = nullptr);
+    ~AudioCapture();
+
+    bool start(const CaptureOptions& options);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    unsigned int sampleRate() const { return actualRate; }
+    unsigned int channelCount() const { return actualChannels; }
+    // Размер кадра в отсчётах (период * число каналов)
+    size_t frameSamples() const { return frameSize * actualChannels; }
+    bool usesMmap() const { return mmapAccess; }
+
+    // --- Сторона потока распознавания ---
+    size_t peek(const short** data) const { return ring->peek(data); }
+    void consume(size_t count) { ring->consume(count); }
+    // Разрешает следующий сигнал framesAvailable(). Вызывается перед разбором буфера.
+    void rearmNotification() { notifyPending.store(false, std::memory_order_release); }
+
+    CaptureStats stats() const;
+
+signals:
+    // Испускается из потока захвата, не чаще одного раза до вызова rearmNotification()
+    void framesAvailable();
+    void logMessage(const QString& message);
+    // Поток захвата завершился сам, без stop(): устройство не восстановилось после ошибки.
+    // Испускается из потока захвата; isRunning() к этому моменту уже false
+    void captureFailed();
+
+private:
+    void captureLoop();
+    void blockingLoop();
+    void pollLoop();
+    snd_pcm_sframes_t readPeriod();
+    snd_pcm_sframes_t readPeriodMmap();
+    bool pushSamples(const short* data, size_t count);
+    void updatePeakFill();
+    void notifyConsumer();
+    bool recoverDevice(int err);
+    void applyThreadPolicy();
+    void closeDevice();
+
+    CaptureOptions options;
+    snd_pcm_t *captureHandle;
+    unsigned int actualRate;
+    unsigned int actualChannels;
+    size_t frameSize;               // В кадрах ALSA (один отсчёт на канал)
+    bool mmapAccess;
+
+    std::unique_ptr<SpscRingBuffer<short>> ring;
+    std::vector<short> frameBuffer;
+    std::thread captureThread;
+    int wakeFd;                     // eventfd для пробуждения poll() при остановке
+    std::atomic<bool> running;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> notifyPending;
+
+    std::atomic<uint64_t> framesCaptured;
+    std::atomic<uint64_t> framesDropped;
+    std::atomic<uint64_t> xruns;
+    std::atomic<size_t> peakFill;
+};
+
+#endif // AUDIOCAPTURE_H
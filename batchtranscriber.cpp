@@ -0,0 +1,370 @@
+#include "batchtranscriber.h"
+#include "resampler.h"
+#include "resultparser.h"
+#include "voiceassistant.h"
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#define BATCH_SAMPLE_RATE 16000
+#define BATCH_CHUNK (BATCH_SAMPLE_RATE / 5)    // 200 мс на вызов распознавателя
+#define BATCH_STREAMS 32                       // Одновременных потоков в VoskBatchModel
+#define RESAMPLE_BLOCK 8192
+
+static uint16_t readLe16(const char* p)
+{
+    return static_cast<uint16_t>(static_cast<unsigned char>(p[0]) | (static_cast<unsigned char>(p[1]) << 8));
+}
+
+static uint32_t readLe32(const char* p)
+{
+    return static_cast<uint32_t>(readLe16(p)) | (static_cast<uint32_t>(readLe16(p + 2)) << 16);
+}
+
+// Дописывает текст из JSON результата Vosk через пробел
+static void appendText(std::string& text, const char* json)
+{
+    std::string part = resultText(json);
+    if (part.empty()) return;
+    if (!text.empty()) {
+        text += ' ';
+    }
+    text += part;
+}
+
+BatchTranscriber::BatchTranscriber(const BatchOptions& options)
+    : options(options)
+{
+}
+
+bool BatchTranscriber::loadAudio(const std::string& path, unsigned int rawSampleRate, unsigned int rawChannels,
+                                 std::vector<short>& samples, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "не удалось открыть файл";
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    unsigned int rate = rawSampleRate;
+    unsigned int channels = rawChannels;
+    const char* pcm = data.data();
+    size_t pcmBytes = data.size();
+
+    if (data.size() >= 12 && std::memcmp(data.data(), "RIFF", 4) == 0 && std::memcmp(data.data() + 8, "WAVE", 4) == 0) {
+        bool haveFormat = false;
+        pcm = nullptr;
+        pcmBytes = 0;
+
+        size_t pos = 12;
+        while (pos + 8 <= data.size()) {
+            uint32_t chunkSize = readLe32(data.data() + pos + 4);
+            const char* body = data.data() + pos + 8;
+            // Потоковые записи оставляют размер 0xFFFFFFFF — берём сколько есть
+            size_t available = std::min<size_t>(chunkSize, data.size() - pos - 8);
+
+            if (std::memcmp(data.data() + pos, "fmt ", 4) == 0 && available >= 16) {
+                uint16_t format = readLe16(body);
+                channels = readLe16(body + 2);
+                rate = readLe32(body + 4);
+                uint16_t bits = readLe16(body + 14);
+                // 0xFFFE — WAVE_FORMAT_EXTENSIBLE
+                if ((format != 1 && format != 0xFFFE) || bits != 16) {
+                    error = "поддерживается только WAV PCM 16 бит";
+                    return false;
+                }
+                haveFormat = true;
+            } else if (std::memcmp(data.data() + pos, "data", 4) == 0) {
+                pcm = body;
+                pcmBytes = available;
+            }
+            pos += 8 + static_cast<size_t>(chunkSize) + (chunkSize & 1);
+        }
+
+        if (!haveFormat || pcm == nullptr) {
+            error = "повреждённый WAV: нет блока fmt или data";
+            return false;
+        }
+    }
+
+    if (rate == 0 || channels == 0) {
+        error = "неверный формат звука";
+        return false;
+    }
+
+    const size_t frames = pcmBytes / (sizeof(short) * channels);
+    std::vector<short> interleaved(frames * channels);
+    std::memcpy(interleaved.data(), pcm, interleaved.size() * sizeof(short));
+
+    Resampler resampler;
+    resampler.configure(rate, channels, BATCH_SAMPLE_RATE, RESAMPLE_BLOCK);
+    if (resampler.isPassthrough()) {
+        samples.swap(interleaved);
+        return true;
+    }
+
+    samples.clear();
+    samples.reserve(resampler.maxOutput(frames));
+    std::vector<short> block(resampler.maxOutput(RESAMPLE_BLOCK));
+    for (size_t offset = 0; offset < frames; offset += RESAMPLE_BLOCK) {
+        size_t n = std::min<size_t>(RESAMPLE_BLOCK, frames - offset);
+        size_t produced = resampler.process(interleaved.data() + offset * channels, n, block.data());
+        samples.insert(samples.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(produced));
+    }
+    return true;
+}
+
+bool BatchTranscriber::run(std::vector<BatchFileResult>& results, BatchSummary& summary, std::string& error)
+{
+    results.assign(options.files.size(), BatchFileResult());
+    for (size_t i = 0; i < options.files.size(); ++i) {
+        results[i].file = options.files[i];
+    }
+    summary = BatchSummary();
+    summary.files = results.size();
+
+    std::chrono::steady_clock::time_point begin;
+    if (options.useBatchApi) {
+        VoskBatchModel* batchModel = vosk_batch_model_new(options.modelPath.c_str());
+        if (batchModel) {
+            summary.batchApi = true;
+            begin = std::chrono::steady_clock::now();
+            runBatchModel(batchModel, results);
+            vosk_batch_model_free(batchModel);
+        } else {
+            qWarning() << "VoskBatchModel недоступна (libvosk собрана без CUDA), используется пул распознавателей";
+        }
+    }
+
+    if (!summary.batchApi) {
+        VoskModel* model = vosk_model_new(options.modelPath.c_str());
+        if (!model) {
+            error = "не удалось загрузить модель " + options.modelPath;
+            return false;
+        }
+
+        unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, std::max<size_t>(1, results.size())));
+        summary.threads = threads;
+
+        // Загрузка модели в RTF не входит
+        begin = std::chrono::steady_clock::now();
+        runPool(model, threads, results);
+        vosk_model_free(model);
+    }
+
+    summary.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    for (const auto& result : results) {
+        summary.audioSeconds += result.audioSeconds;
+        if (!result.error.empty()) {
+            ++summary.failed;
+        }
+    }
+    return true;
+}
+
+void BatchTranscriber::runPool(VoskModel* model, unsigned int threads, std::vector<BatchFileResult>& results)
+{
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        // Распознаватель на поток создаётся один раз и переиспользуется для всех его файлов
+        VoskRecognizer* recognizer = vosk_recognizer_new(model, BATCH_SAMPLE_RATE);
+        std::vector<short> samples;
+        size_t index;
+        while ((index = next.fetch_add(1)) < results.size()) {
+            BatchFileResult& result = results[index];
+            if (!recognizer) {
+                result.error = "не удалось создать распознаватель";
+                continue;
+            }
+            if (!loadAudio(result.file, options.rawSampleRate, options.rawChannels, samples, result.error)) {
+                continue;
+            }
+            result.audioSeconds = static_cast<double>(samples.size()) / BATCH_SAMPLE_RATE;
+
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset < samples.size(); offset += BATCH_CHUNK) {
+                int n = static_cast<int>(std::min<size_t>(BATCH_CHUNK, samples.size() - offset));
+                if (vosk_recognizer_accept_waveform_s(recognizer, samples.data() + offset, n) > 0) {
+                    appendText(result.text, vosk_recognizer_result(recognizer));
+                }
+            }
+            // final_result также сбрасывает распознаватель для следующего файла
+            appendText(result.text, vosk_recognizer_final_result(recognizer));
+            result.processingSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        if (recognizer) {
+            vosk_recognizer_free(recognizer);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void BatchTranscriber::runBatchModel(VoskBatchModel* model, std::vector<BatchFileResult>& results)
+{
+    // Файлы идут окнами по BATCH_STREAMS: батч на GPU собирается из одновременно активных потоков
+    for (size_t first = 0; first < results.size(); first += BATCH_STREAMS) {
+        const size_t count = std::min<size_t>(BATCH_STREAMS, results.size() - first);
+        std::vector<std::vector<short>> audio(count);
+        std::vector<VoskBatchRecognizer*> recognizers(count, nullptr);
+
+        for (size_t k = 0; k < count; ++k) {
+            BatchFileResult& result = results[first + k];
+            if (!loadAudio(result.file, options.rawSampleRate, options.rawChannels, audio[k], result.error)) {
+                continue;
+            }
+            result.audioSeconds = static_cast<double>(audio[k].size()) / BATCH_SAMPLE_RATE;
+            if (audio[k].empty()) continue;
+
+            recognizers[k] = vosk_batch_recognizer_new(model, BATCH_SAMPLE_RATE);
+            if (!recognizers[k]) {
+                result.error = "не удалось создать пакетный распознаватель";
+            }
+        }
+
+        // Куски всех файлов подаются по очереди, чтобы потоки продвигались вместе
+        bool pending = true;
+        for (size_t offset = 0; pending; offset += BATCH_CHUNK) {
+            pending = false;
+            for (size_t k = 0; k < count; ++k) {
+                if (!recognizers[k] || offset >= audio[k].size()) continue;
+
+                size_t n = std::min<size_t>(BATCH_CHUNK, audio[k].size() - offset);
+                vosk_batch_recognizer_accept_waveform(recognizers[k],
+                                                      reinterpret_cast<const char*>(audio[k].data() + offset),
+                                                      static_cast<int>(n * sizeof(short)));
+                if (offset + n >= audio[k].size()) {
+                    vosk_batch_recognizer_finish_stream(recognizers[k]);
+                } else {
+                    pending = true;
+                }
+            }
+        }
+
+        vosk_batch_model_wait(model);
+        for (size_t k = 0; k < count; ++k) {
+            if (!recognizers[k]) continue;
+            const char* json;
+            while ((json = vosk_batch_recognizer_front_result(recognizers[k])) != nullptr && *json) {
+                appendText(results[first + k].text, json);
+                vosk_batch_recognizer_pop(recognizers[k]);
+            }
+            vosk_batch_recognizer_free(recognizers[k]);
+        }
+    }
+}
+
+int runBatchMode(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Пакетное распознавание аудиофайлов без графического интерфейса");
+    parser.addHelpOption();
+    QCommandLineOption batchOption("batch", "Пакетный режим");
+    QCommandLineOption modelOption("model", "Каталог модели Vosk (по умолчанию ищется как при обычном запуске)", "dir");
+    QCommandLineOption threadsOption("threads", "Число потоков распознавания (0 — по числу ядер)", "n", "0");
+    QCommandLineOption gpuOption("gpu", "Распознавать через VoskBatchModel (нужна libvosk с CUDA)");
+    QCommandLineOption outputOption("output", "Файл результатов JSON Lines (по умолчанию stdout)", "file");
+    QCommandLineOption rawRateOption("raw-rate", "Частота файлов без заголовка (.raw/.pcm)", "hz", "16000");
+    QCommandLineOption rawChannelsOption("raw-channels", "Число каналов файлов без заголовка", "n", "1");
+    parser.addOption(batchOption);
+    parser.addOption(modelOption);
+    parser.addOption(threadsOption);
+    parser.addOption(gpuOption);
+    parser.addOption(outputOption);
+    parser.addOption(rawRateOption);
+    parser.addOption(rawChannelsOption);
+    parser.addPositionalArgument("files", "WAV (PCM 16 бит) или raw s16le файлы", "files...");
+    parser.process(arguments);
+
+    QTextStream err(stderr);
+
+    BatchOptions options;
+    options.modelPath = parser.isSet(modelOption) ? parser.value(modelOption).toStdString() : findModelPath();
+    options.threads = parser.value(threadsOption).toUInt();
+    options.useBatchApi = parser.isSet(gpuOption);
+    options.rawSampleRate = parser.value(rawRateOption).toUInt();
+    options.rawChannels = parser.value(rawChannelsOption).toUInt();
+    for (const QString& file : parser.positionalArguments()) {
+        options.files.push_back(file.toStdString());
+    }
+
+    if (options.files.empty()) {
+        err << "Не указаны файлы для распознавания\n";
+        return 2;
+    }
+    if (options.modelPath.empty()) {
+        err << "Модель Vosk не найдена, укажите её через --model\n";
+        return 1;
+    }
+
+    // Журнал Kaldi в stderr перемешался бы со сводкой
+    vosk_set_log_level(-1);
+
+    QFile output;
+    bool opened;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        err << "Не удалось открыть файл результатов: " << output.fileName() << "\n";
+        return 1;
+    }
+
+    BatchTranscriber transcriber(options);
+    std::vector<BatchFileResult> results;
+    BatchSummary summary;
+    std::string error;
+    if (!transcriber.run(results, summary, error)) {
+        err << "Ошибка: " << QString::fromStdString(error) << "\n";
+        return 1;
+    }
+
+    for (const auto& result : results) {
+        QJsonObject line;
+        line["file"] = QString::fromStdString(result.file);
+        line["text"] = QString::fromStdString(result.text);
+        line["audioSec"] = result.audioSeconds;
+        line["processingSec"] = result.processingSeconds;
+        if (!result.error.empty()) {
+            line["error"] = QString::fromStdString(result.error);
+        }
+        output.write(QJsonDocument(line).toJson(QJsonDocument::Compact));
+        output.write("\n");
+    }
+    output.close();
+
+    err << QString("Файлов: %1 (ошибок %2), аудио %3 с за %4 с, RTF %5, %6 файлов/с, %7\n")
+           .arg(summary.files)
+           .arg(summary.failed)
+           .arg(summary.audioSeconds, 0, 'f', 1)
+           .arg(summary.wallSeconds, 0, 'f', 2)
+           .arg(summary.realTimeFactor(), 0, 'f', 3)
+           .arg(summary.filesPerSecond(), 0, 'f', 1)
+           .arg(summary.batchApi ? QString("VoskBatchModel")
+                                 : QString("пул из %1 распознавателей").arg(summary.threads));
+    return summary.failed ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+#ifndef BATCHTRANSCRIBER_H
+#define BATCHTRANSCRIBER_H
+
+#include "vosk_api.h"
+#include <QStringList>
+#include <string>
+#include <vector>
+
+// Параметры пакетного распознавания файлов
+struct BatchOptions {
+    std::string modelPath;
+    std::vector<std::string> files;
+    unsigned int threads = 0;           // 0 — по числу ядер
+    bool useBatchApi = false;           // VoskBatchModel (нужна libvosk с CUDA)
+    unsigned int rawSampleRate = 16000; // Формат файлов .raw/.pcm без заголовка (s16le)
+    unsigned int rawChannels = 1;
+};
+
+// Результат по одному файлу
+struct BatchFileResult {
+    std::string file;
+    std::string text;
+    std::string error;
+    double audioSeconds = 0.0;
+    double processingSeconds = 0.0;     // Время распознавания без чтения файла
+};
+
+// Сводка по всему прогону
+struct BatchSummary {
+    size_t files = 0;
+    size_t failed = 0;
+    unsigned int threads = 0;
+    bool batchApi = false;
+    double audioSeconds = 0.0;
+    double wallSeconds = 0.0;
+
+    // Меньше 1 — быстрее реального времени
+    double realTimeFactor() const { return audioSeconds > 0.0 ? wallSeconds / audioSeconds : 0.0; }
+    double filesPerSecond() const { return wallSeconds > 0.0 ? files / wallSeconds : 0.0; }
+};
+
+// Офлайн-распознавание набора WAV/raw файлов одной моделью.
+// Файлы раздаются пулу потоков, у каждого свой VoskRecognizer на общей VoskModel;
+// при useBatchApi звук идёт через VoskBatchModel, а если она недоступна — через тот же пул.
+class BatchTranscriber
+{
+public:
+    explicit BatchTranscriber(const BatchOptions& options);
+
+    bool run(std::vector<BatchFileResult>& results, BatchSummary& summary, std::string& error);
+
+    // Читает WAV (PCM 16 бит) или raw файл и приводит его к 16 кГц моно
+    static bool loadAudio(const std::string& path, unsigned int rawSampleRate, unsigned int rawChannels,
+                          std::vector<short>& samples, std::string& error);
+
+private:
+    void runPool(VoskModel* model, unsigned int threads, std::vector<BatchFileResult>& results);
+    void runBatchModel(VoskBatchModel* model, std::vector<BatchFileResult>& results);
+
+    BatchOptions options;
+};
+
+// Точка входа режима --batch: разбирает аргументы, пишет результаты в JSON Lines, возвращает код выхода
+int runBatchMode(const QStringList& arguments);
+
+#endif // BATCHTRANSCRIBER_H
@@ -0,0 +1,264 @@
+#include "commandscorer.h"
+#include "textfold.h"
+#include <algorithm>
+#include <cmath>
+
+// Ниже этой доли вероятности вариант N-best не учитывается
+#define MIN_ALTERNATIVE_WEIGHT 1e-6
+
+CommandScorer::CommandScorer(const KeywordMatcher& exact, const FuzzyMatcher& fuzzy)
+    : exact(exact)
+    , fuzzy(fuzzy)
+{
+}
+
+// Номер слова для байта свёрнутого текста: слова разделены ровно одним пробелом
+static size_t wordIndexAt(std::string_view folded, size_t position)
+{
+    return static_cast<size_t>(std::count(folded.begin(), folded.begin() + position, ' '));
+}
+
+// Начало слова с номером index
+static size_t wordStart(std::string_view folded, size_t index)
+{
+    size_t pos = 0;
+    for (size_t i = 0; i < index && pos != std::string_view::npos; ++i) {
+        pos = folded.find(' ', pos);
+        if (pos != std::string_view::npos) ++pos;
+    }
+    return pos == std::string_view::npos ? folded.size() : pos;
+}
+
+// Конец слова, в котором стоит position
+static size_t wordEnd(std::string_view folded, size_t position)
+{
+    size_t end = folded.find(' ', position);
+    return end == std::string_view::npos ? folded.size() : end;
+}
+
+bool CommandScorer::match(std::string_view folded, CommandHit& hit, bool allowFuzzy) const
+{
+    KeywordMatch keyword;
+    if (exact.match(folded, keyword)) {
+        size_t start = keyword.end - keyword.length;
+        hit.command = keyword.command;
+        hit.priority = keyword.priority;
+        hit.firstWord = wordIndexAt(folded, start);
+        hit.wordCount = wordIndexAt(folded, keyword.end) - hit.firstWord + 1;
+        hit.start = start;
+        hit.end = wordEnd(folded, keyword.end);
+        hit.fuzzy = false;
+        hit.distance = 0;
+        hit.length = keyword.length;
+        return true;
+    }
+
+    FuzzyMatch phrase;
+    if (allowFuzzy && fuzzy.match(folded, phrase)) {
+        hit.command = phrase.command;
+        hit.priority = phrase.priority;
+        hit.firstWord = phrase.firstWord;
+        hit.wordCount = phrase.wordCount;
+        hit.start = wordStart(folded, phrase.firstWord);
+        hit.end = wordEnd(folded, wordStart(folded, phrase.firstWord + phrase.wordCount - 1));
+        hit.fuzzy = true;
+        hit.distance = phrase.distance;
+        hit.length = phrase.length;
+        return true;
+    }
+    return false;
+}
+
+std::string_view CommandScorer::foldString(const JsonString& text) const
+{
+    static thread_local std::string decoded;
+    static thread_local std::string folded;
+    if (!text.escaped) {
+        return foldText(text.raw, folded);
+    }
+    decoded.resize(text.raw.size());
+    decoded.resize(text.decode(&decoded[0], decoded.size()));
+    return foldText(decoded, folded);
+}
+
+// Доля верных звуков нечёткого совпадения (1 для точного)
+static double hitFactor(const CommandHit& hit)
+{
+    if (!hit.fuzzy || hit.length == 0) return 1.0;
+    return std::max(0.0, 1.0 - static_cast<double>(hit.distance) / hit.length);
+}
+
+size_t CommandScorer::alternativeWeights(const RecognitionResult& result, double* weights)
+{
+    size_t count = result.alternativeCount;
+    if (count == 0) return 0;
+
+    // exp от разности с лучшим вариантом: без переполнения при любых абсолютных значениях
+    double top = result.alternatives[0].confidence;
+    for (size_t i = 1; i < count; ++i) {
+        top = std::max(top, result.alternatives[i].confidence);
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        weights[i] = std::exp(result.alternatives[i].confidence - top);
+        sum += weights[i];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        weights[i] /= sum;
+    }
+    return count;
+}
+
+bool CommandScorer::matchSpan(std::string_view folded, size_t start, size_t end, size_t firstWord,
+                              bool allowFuzzy, CommandHit& hit) const
+{
+    if (!match(folded.substr(start, end - start), hit, allowFuzzy)) return false;
+    hit.start += start;
+    hit.end += start;
+    hit.firstWord += firstWord;
+    return true;
+}
+
+size_t CommandScorer::matchSegments(std::string_view folded, const RecognizedWord* words, size_t wordCount,
+                                    bool allowFuzzy, const UtteranceSegmenter* segmenter,
+                                    CommandScore* intents) const
+{
+    UtteranceSegment segments[UtteranceSegmenter::MaxSegments];
+    size_t segmentCount = segmenter ? segmenter->split(folded, words, wordCount, segments) : 0;
+    if (segmentCount == 0) {
+        segments[0].start = 0;
+        segments[0].end = folded.size();
+        segmentCount = 1;
+    }
+
+    // Начало участка каждой команды (к нему пристраиваются куски без команды)
+    size_t spanStart[MaxIntents];
+    size_t spanWord[MaxIntents];
+    size_t count = 0;
+    bool open = false;                  // Участок без команды ждёт следующего куска
+    size_t start = 0;
+    size_t firstWord = 0;
+    bool sequential = false;
+    for (size_t i = 0; i < segmentCount; ++i) {
+        const UtteranceSegment& segment = segments[i];
+        if (!open) {
+            start = segment.start;
+            firstWord = segment.firstWord;
+            sequential = segment.sequential;
+        }
+
+        CommandHit hit;
+        if (matchSpan(folded, start, segment.end, firstWord, allowFuzzy, hit)) {
+            CommandScore& intent = intents[count];
+            intent = CommandScore();
+            intent.hit = hit;
+            intent.segmentEnd = segment.end;
+            intent.sequential = sequential && count > 0;
+            spanStart[count] = start;
+            spanWord[count] = firstWord;
+            ++count;
+            open = false;
+        } else if (count > 0) {
+            // Продолжение предыдущей команды: "таймер на две минуты" + "и десять секунд"
+            CommandScore& previous = intents[count - 1];
+            if (matchSpan(folded, spanStart[count - 1], segment.end, spanWord[count - 1], allowFuzzy, hit)) {
+                previous.hit = hit;
+            }
+            previous.segmentEnd = segment.end;
+            open = false;
+        } else {
+            // Начало фразы без команды ("ассистент пожалуйста") остаётся перед следующим куском
+            open = true;
+        }
+    }
+    return count;
+}
+
+size_t CommandScorer::score(const RecognitionResult& result, bool allowFuzzy, const UtteranceSegmenter* segmenter,
+                            CommandScore* intents) const
+{
+    if (result.alternativeCount == 0) {
+        size_t count = matchSegments(foldString(result.text), result.words, result.wordCount, allowFuzzy,
+                                     segmenter, intents);
+        for (size_t k = 0; k < count; ++k) {
+            CommandScore& intent = intents[k];
+            double sum = 0.0;
+            size_t confCount = 0;
+            size_t last = std::min(intent.hit.firstWord + intent.hit.wordCount, result.wordCount);
+            for (size_t i = intent.hit.firstWord; i < last; ++i) {
+                if (result.words[i].conf >= 0.0f) {
+                    sum += result.words[i].conf;
+                    ++confCount;
+                }
+            }
+            intent.measured = confCount > 0;
+            intent.score = (intent.measured ? sum / confCount : 1.0) * hitFactor(intent.hit);
+            intent.supporting = 1;
+        }
+        return count;
+    }
+
+    // Команды каждого варианта и их вклад: вес варианта × доля верных звуков
+    double weights[RecognitionResult::MaxAlternatives];
+    size_t alternativeCount = alternativeWeights(result, weights);
+    int commands[RecognitionResult::MaxAlternatives][MaxIntents];
+    double votes[RecognitionResult::MaxAlternatives][MaxIntents];
+    size_t counts[RecognitionResult::MaxAlternatives];
+    CommandScore candidate[MaxIntents];
+    for (size_t i = 0; i < alternativeCount; ++i) {
+        counts[i] = 0;
+        if (weights[i] < MIN_ALTERNATIVE_WEIGHT) continue;
+        const RecognitionAlternative& alternative = result.alternatives[i];
+        counts[i] = matchSegments(foldString(alternative.text), result.words + alternative.firstWord,
+                                  alternative.wordCount, allowFuzzy, segmenter, candidate);
+        for (size_t k = 0; k < counts[i]; ++k) {
+            commands[i][k] = candidate[k].hit.command;
+            votes[i][k] = weights[i] * hitFactor(candidate[k].hit);
+        }
+    }
+
+    // Оценка команды — сумма голосов всех вариантов, где она есть (каждый вариант голосует один раз)
+    auto mass = [&](int command, size_t& supporting) {
+        double total = 0.0;
+        supporting = 0;
+        for (size_t i = 0; i < alternativeCount; ++i) {
+            for (size_t k = 0; k < counts[i]; ++k) {
+                if (commands[i][k] == command) {
+                    total += votes[i][k];
+                    ++supporting;
+                    break;
+                }
+            }
+        }
+        return total;
+    };
+
+    // Вариант с наибольшей суммой оценок своих команд; при равенстве — более вероятный
+    size_t best = alternativeCount;
+    double bestTotal = 0.0;
+    for (size_t i = 0; i < alternativeCount; ++i) {
+        double total = 0.0;
+        for (size_t k = 0; k < counts[i]; ++k) {
+            size_t supporting;
+            total += mass(commands[i][k], supporting);
+        }
+        if (counts[i] > 0 && (best == alternativeCount || total > bestTotal)) {
+            best = i;
+            bestTotal = total;
+        }
+    }
+    if (best == alternativeCount) return 0;
+
+    // Разбор выбранного варианта повторяется: буфер свёртки общий для всех вариантов
+    const RecognitionAlternative& chosen = result.alternatives[best];
+    size_t count = matchSegments(foldString(chosen.text), result.words + chosen.firstWord, chosen.wordCount,
+                                 allowFuzzy, segmenter, intents);
+    for (size_t k = 0; k < count; ++k) {
+        CommandScore& intent = intents[k];
+        intent.score = mass(intent.hit.command, intent.supporting);
+        intent.measured = true;
+        intent.alternative = best;
+        intent.alternatives = alternativeCount;
+    }
+    return count;
+}
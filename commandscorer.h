@@ -0,0 +1,75 @@
+#ifndef COMMANDSCORER_H
+#define COMMANDSCORER_H
+
+#include "keywordmatcher.h"
+#include "fuzzymatcher.h"
+#include "resultparser.h"
+#include "segmenter.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Команда, найденная в одном тексте
+struct CommandHit {
+    int command = -1;
+    int priority = 0;
+    size_t firstWord = 0;               // Слова текста [firstWord, firstWord + wordCount)
+    size_t wordCount = 0;
+    size_t start = 0;                   // Байты совпадения в свёрнутом тексте; end — конец последнего слова
+    size_t end = 0;
+    bool fuzzy = false;
+    int distance = 0;                   // Для нечёткого совпадения — число ошибок в звуках
+    size_t length = 0;                  // Длина совпадения: байты (точное) или звуки (нечёткое)
+};
+
+// Итоговая оценка одной команды (намерения) фразы
+struct CommandScore {
+    CommandHit hit;                     // Совпадение в выбранном варианте; байты — в его свёрнутом тексте
+    double score = 0.0;                 // 0..1
+    bool measured = false;              // false — в результате нет ни N-best, ни conf слов
+    size_t alternative = 0;             // Номер этого варианта в N-best
+    size_t supporting = 0;              // Сколько вариантов указывают на команду
+    size_t alternatives = 0;            // Сколько вариантов всего (0 — результат без N-best)
+    size_t segmentEnd = 0;              // Конец куска фразы с командой: дальше параметры не ищутся
+    bool sequential = false;            // Выполнять после предыдущих команд фразы
+};
+
+// Оценка команд по результату Vosk вместо ответа «да/нет» по лучшему тексту.
+// Фраза может содержать несколько команд: текст делится UtteranceSegmenter, кусок без команды
+// присоединяется к предыдущему.
+// N-best: каждый вариант голосует за свои команды с весом, пропорциональным exp(confidence)
+// (confidence варианта — логарифм его правдоподобия в решётке), оценка команды — доля
+// вероятности всех вариантов, где она найдена. Выбирается вариант с наибольшей суммой оценок.
+// Один результат со словами: оценка — средний conf слов, на которые пришлось совпадение.
+// Нечёткое совпадение дополнительно умножается на долю верных звуков.
+class CommandScorer
+{
+public:
+    static const size_t MaxIntents = UtteranceSegmenter::MaxSegments;
+
+    CommandScorer(const KeywordMatcher& exact, const FuzzyMatcher& fuzzy);
+
+    // Текст должен быть свёрнут (foldText). Сначала точный автомат, затем нечёткий поиск (allowFuzzy)
+    bool match(std::string_view folded, CommandHit& hit, bool allowFuzzy) const;
+    // Команды фразы по порядку (не больше MaxIntents); segmenter = nullptr — одна команда на фразу.
+    // Возвращает их число
+    size_t score(const RecognitionResult& result, bool allowFuzzy, const UtteranceSegmenter* segmenter,
+                 CommandScore* intents) const;
+
+    // Нормированные веса вариантов N-best, возвращает их число
+    static size_t alternativeWeights(const RecognitionResult& result, double* weights);
+
+private:
+    std::string_view foldString(const JsonString& text) const;
+    // match() по участку [start, end) свёрнутого текста; позиции и номера слов — во всём тексте
+    bool matchSpan(std::string_view folded, size_t start, size_t end, size_t firstWord, bool allowFuzzy,
+                   CommandHit& hit) const;
+    // Команды одного текста по кускам
+    size_t matchSegments(std::string_view folded, const RecognizedWord* words, size_t wordCount, bool allowFuzzy,
+                         const UtteranceSegmenter* segmenter, CommandScore* intents) const;
+
+    const KeywordMatcher& exact;
+    const FuzzyMatcher& fuzzy;
+};
+
+#endif // COMMANDSCORER_H
@@ -0,0 +1,334 @@
+#include "fanout.h"
+#include "resultparser.h"
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+
+// Мест в очереди ветви под концы фраз сверх блоков звука
+#define FANOUT_RESULT_SLOTS 4
+
+RecognizerFanout::RecognizerFanout()
+    : running(false)
+    , current(nullptr)
+    , maxQueuedBlocks(0)
+{
+}
+
+RecognizerFanout::~RecognizerFanout()
+{
+    stop();
+    for (auto& branch : branches) {
+        vosk_recognizer_free(branch->recognizer);
+    }
+}
+
+void RecognizerFanout::addBranch(const std::string& name, VoskRecognizer* recognizer, int cpuCore, bool grammar)
+{
+    auto branch = std::make_unique<Branch>();
+    branch->name = name;
+    branch->recognizer = recognizer;
+    branch->cpuCore = cpuCore;
+    branch->grammar = grammar;
+    branch->stats.name = name;
+    branches.push_back(std::move(branch));
+}
+
+void RecognizerFanout::start(ResultHandler resultHandler, unsigned int maxQueueMs)
+{
+    if (running) return;
+    handler = resultHandler;
+
+    // Всё, что нужно для передачи звука, выделяется здесь, а не на каждый блок
+    maxQueuedBlocks = std::max<size_t>(1, static_cast<size_t>(maxQueueMs) * 16 / AudioBlock::Samples);
+    // Отставшие в разное время ветви держат в основном разные блоки: каждой — полная очередь и блок
+    // в распознавателе, плюс заполняемый current. Меньший пул при отставании одной ветви отнимал бы звук у всех
+    const size_t blockCount = branches.size() * (maxQueuedBlocks + 1) + 1;
+    blocks.reset(new AudioBlock[blockCount]);
+    freeBlocks.clear();
+    freeBlocks.reserve(blockCount);
+    for (size_t i = 0; i < blockCount; ++i) {
+        freeBlocks.push_back(&blocks[i]);
+    }
+    current = nullptr;
+
+    for (auto& branch : branches) {
+        branch->ring.assign(maxQueuedBlocks + FANOUT_RESULT_SLOTS, Message());
+        branch->head = 0;
+        branch->size = 0;
+        branch->queuedBlocks = 0;
+        branch->stopping = false;
+        branch->thread = std::thread(&RecognizerFanout::branchLoop, this, branch.get());
+    }
+    running = true;
+}
+
+void RecognizerFanout::stop()
+{
+    if (!running) return;
+    for (auto& branch : branches) {
+        {
+            std::lock_guard<std::mutex> lock(branch->mutex);
+            branch->stopping = true;
+        }
+        branch->wake.notify_one();
+    }
+    for (auto& branch : branches) {
+        branch->thread.join();
+    }
+    running = false;
+
+    // Блоки, которые ветви не успели разобрать, возвращаются в пул
+    for (auto& branch : branches) {
+        for (; branch->size > 0; --branch->size) {
+            if (AudioBlock* block = branch->ring[branch->head].block) {
+                releaseBlock(block);
+            }
+            branch->head = (branch->head + 1) % branch->ring.size();
+        }
+        branch->queuedBlocks = 0;
+    }
+    if (current) {
+        current->refs = 1;
+        releaseBlock(current);
+        current = nullptr;
+    }
+}
+
+void RecognizerFanout::setGrammar(const std::string& grammar)
+{
+    for (auto& branch : branches) {
+        if (!branch->grammar) continue;
+        {
+            std::lock_guard<std::mutex> lock(branch->mutex);
+            branch->newGrammar = grammar;
+            branch->grammarChanged = true;
+        }
+        branch->wake.notify_one();
+    }
+}
+
+std::vector<FanoutBranchStats> RecognizerFanout::stats() const
+{
+    std::vector<FanoutBranchStats> result;
+    for (const auto& branch : branches) {
+        result.push_back(branch->stats);
+    }
+    return result;
+}
+
+void RecognizerFanout::releaseBlock(AudioBlock* block)
+{
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    std::lock_guard<std::mutex> lock(poolMutex);
+    freeBlocks.push_back(block);
+}
+
+void RecognizerFanout::push(const short* samples, size_t count)
+{
+    if (count == 0 || !running) return;
+
+    while (count > 0) {
+        if (!current) {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            // Пул рассчитан на полные очереди всех ветвей одновременно и сюда не доходит; на всякий случай звук пропускается
+            if (freeBlocks.empty()) {
+                for (auto& branch : branches) {
+                    ++branch->stats.droppedBlocks;
+                }
+                return;
+            }
+            current = freeBlocks.back();
+            freeBlocks.pop_back();
+            current->count = 0;
+        }
+        // Единственная копия звука; дальше ветви держат ссылки на блок
+        size_t n = std::min(count, AudioBlock::Samples - current->count);
+        std::copy(samples, samples + n, current->samples + current->count);
+        current->count += n;
+        samples += n;
+        count -= n;
+        if (current->count == AudioBlock::Samples) {
+            flush();
+        }
+    }
+}
+
+void RecognizerFanout::flush()
+{
+    if (!current) return;
+    AudioBlock* block = current;
+    current = nullptr;
+
+    // Каждая ветвь, не принявшая блок, сразу отпускает свою ссылку
+    block->refs.store(static_cast<unsigned int>(branches.size()), std::memory_order_relaxed);
+    for (auto& branch : branches) {
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(branch->mutex);
+            if (branch->queuedBlocks < maxQueuedBlocks) {
+                branch->ring[(branch->head + branch->size) % branch->ring.size()] = Message{block, 0};
+                ++branch->size;
+                ++branch->queuedBlocks;
+                branch->stats.peakQueue = std::max(branch->stats.peakQueue, branch->queuedBlocks);
+                queued = true;
+            } else {
+                ++branch->stats.droppedBlocks;
+            }
+        }
+        if (queued) {
+            branch->wake.notify_one();
+        } else {
+            releaseBlock(block);
+        }
+    }
+}
+
+void RecognizerFanout::finish(uint64_t utterance)
+{
+    if (!running) return;
+    // Неполный последний блок фразы уходит сразу
+    flush();
+    for (auto& branch : branches) {
+        {
+            std::lock_guard<std::mutex> lock(branch->mutex);
+            if (branch->size == branch->ring.size()) {
+                ++branch->stats.droppedResults;
+                continue;
+            }
+            branch->ring[(branch->head + branch->size) % branch->ring.size()] = Message{nullptr, utterance};
+            ++branch->size;
+        }
+        branch->wake.notify_one();
+    }
+}
+
+void RecognizerFanout::parseResult(std::string_view json, std::string& text, double& confidenceSum, size_t& words)
+{
+    static thread_local RecognitionResult result;
+    confidenceSum = 0.0;
+    words = 0;
+    if (!ResultParser::parse(json, result)) {
+        text.clear();
+        return;
+    }
+    text = result.text.str();
+    for (size_t i = 0; i < result.wordCount; ++i) {
+        if (result.words[i].conf >= 0.0f) {
+            confidenceSum += result.words[i].conf;
+        }
+        ++words;
+    }
+}
+
+std::string RecognizerFanout::mergeResults(const std::string& text, const std::vector<std::string>& results)
+{
+    // Обычно итог один — передаётся без изменений
+    if (results.size() == 1) {
+        return results.front();
+    }
+    // Фраза разбита паузами распознавателя на несколько итогов: слова с conf и временем собираются вместе
+    QJsonArray words;
+    for (const auto& item : results) {
+        QJsonObject part = QJsonDocument::fromJson(QByteArray::fromStdString(item)).object();
+        for (const auto& word : part.value("result").toArray()) {
+            words.append(word);
+        }
+    }
+    QJsonObject json;
+    json["result"] = words;
+    json["text"] = QString::fromStdString(text);
+    return QJsonDocument(json).toJson(QJsonDocument::Compact).toStdString();
+}
+
+void RecognizerFanout::collect(Branch* branch, const char* json)
+{
+    std::string text;
+    double confidenceSum;
+    size_t words;
+    parseResult(json, text, confidenceSum, words);
+    if (text.empty()) return;
+
+    if (!branch->pendingText.empty()) {
+        branch->pendingText += ' ';
+    }
+    branch->pendingText += text;
+    branch->pendingJson.push_back(json);
+    branch->confidenceSum += confidenceSum;
+    branch->words += words;
+}
+
+void RecognizerFanout::branchLoop(Branch* branch)
+{
+    if (branch->cpuCore >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(branch->cpuCore, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    }
+
+    std::string grammar;
+    for (;;) {
+        Message message;
+        bool grammarChanged = false;
+        {
+            std::unique_lock<std::mutex> lock(branch->mutex);
+            branch->wake.wait(lock, [branch]() {
+                return branch->stopping || branch->size > 0 || branch->grammarChanged;
+            });
+            if (branch->grammarChanged) {
+                grammar.swap(branch->newGrammar);
+                grammarChanged = true;
+                branch->grammarChanged = false;
+            } else if (branch->size == 0) {
+                return;
+            } else {
+                message = branch->ring[branch->head];
+                branch->head = (branch->head + 1) % branch->ring.size();
+                --branch->size;
+                if (message.block) {
+                    --branch->queuedBlocks;
+                }
+            }
+        }
+
+        if (grammarChanged) {
+            // Распознаватель не потокобезопасен — грамматика меняется только в потоке ветви
+            vosk_recognizer_set_grm(branch->recognizer, grammar.c_str());
+            continue;
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        if (message.block) {
+            const AudioBlock* block = message.block;
+            if (vosk_recognizer_accept_waveform_s(branch->recognizer, block->samples, static_cast<int>(block->count)) > 0) {
+                collect(branch, vosk_recognizer_result(branch->recognizer));
+            }
+            releaseBlock(message.block);
+            ++branch->stats.chunks;
+        } else {
+            collect(branch, vosk_recognizer_final_result(branch->recognizer));
+
+            FanoutResult result;
+            result.utterance = message.utterance;
+            result.branch = branch->name;
+            result.text = branch->pendingText;
+            result.confidence = branch->words ? branch->confidenceSum / branch->words : 0.0;
+            result.json = mergeResults(branch->pendingText, branch->pendingJson);
+            branch->pendingText.clear();
+            branch->pendingJson.clear();
+            branch->confidenceSum = 0.0;
+            branch->words = 0;
+
+            if (handler) {
+                handler(result);
+            }
+        }
+        branch->stats.decodeNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+    }
+}
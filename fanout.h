@@ -0,0 +1,129 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include "vosk_api.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Блок звука из пула, общий для всех ветвей: заполняется один раз, затем только читается.
+// Счётчик ссылок хранится в самом блоке — ни выделения памяти, ни копии на каждую ветвь
+struct AudioBlock {
+    static constexpr size_t Samples = 1600;     // 100 мс при 16 кГц
+    short samples[Samples];
+    size_t count = 0;
+    std::atomic<unsigned int> refs{0};
+};
+
+// Итог фразы в одной ветви
+struct FanoutResult {
+    uint64_t utterance = 0;
+    std::string branch;
+    std::string json;                   // Результат в формате Vosk, передаётся дальше как есть
+    std::string text;
+    double confidence = 0.0;            // Средний conf слов (0 — слов нет)
+};
+
+// Счётчики ветви (снимок после остановки)
+struct FanoutBranchStats {
+    std::string name;
+    uint64_t chunks = 0;
+    uint64_t decodeNs = 0;
+    size_t peakQueue = 0;
+    uint64_t droppedBlocks = 0;         // Ветвь отстала больше чем на maxQueueMs
+    uint64_t droppedResults = 0;        // Конец фразы не поместился в очередь: итога фразы от ветви не будет
+};
+
+// Раздача звука основного потока нескольким распознавателям (другие языки, грамматика рядом с диктовкой).
+// Каждая ветвь декодирует в своём потоке; звук собирается в блоки заранее выделенного пула и передаётся
+// по ссылке со счётчиком, без копии на каждую ветвь. Очередь ветви ограничена: отстающая ветвь пропускает
+// звук, а не копит его. По сигналу конца фразы ветвь возвращает итог с conf слов.
+class RecognizerFanout
+{
+public:
+    // Вызывается из потоков ветвей
+    typedef std::function<void(const FanoutResult&)> ResultHandler;
+
+    RecognizerFanout();
+    ~RecognizerFanout();
+
+    RecognizerFanout(const RecognizerFanout&) = delete;
+    RecognizerFanout& operator=(const RecognizerFanout&) = delete;
+
+    // Распознаватель переходит во владение ветви; cpuCore >= 0 — привязка потока к ядру;
+    // grammar — ветвь распознаёт грамматику команд и получает её обновления
+    void addBranch(const std::string& name, VoskRecognizer* recognizer, int cpuCore = -1, bool grammar = false);
+    // maxQueueMs — сколько звука может ждать отстающая ветвь; пул блоков выделяется здесь
+    void start(ResultHandler handler, unsigned int maxQueueMs = 2000);
+    void stop();
+    // Новая грамматика для ветвей grammar; применяется в их потоках перед следующим блоком
+    void setGrammar(const std::string& grammar);
+
+    size_t branchCount() const { return branches.size(); }
+    std::vector<FanoutBranchStats> stats() const;
+
+    // Дописывает звук в текущий блок пула; заполненный блок ставится в очереди всех ветвей
+    void push(const short* samples, size_t count);
+    // Конец фразы: каждая ветвь вернёт итог с этим номером
+    void finish(uint64_t utterance);
+
+    // Текст, сумма conf и число слов из JSON результата Vosk (нужен vosk_recognizer_set_words)
+    static void parseResult(std::string_view json, std::string& text, double& confidenceSum, size_t& words);
+
+private:
+    struct Message {
+        AudioBlock* block = nullptr;    // nullptr — конец фразы
+        uint64_t utterance = 0;
+    };
+
+    struct Branch {
+        std::string name;
+        VoskRecognizer* recognizer = nullptr;
+        int cpuCore = -1;
+        bool grammar = false;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        // Кольцевая очередь фиксированного размера: блоки звука и концы фраз
+        std::vector<Message> ring;
+        size_t head = 0;
+        size_t size = 0;
+        size_t queuedBlocks = 0;
+        bool stopping = false;
+        std::string newGrammar;         // Под mutex
+        bool grammarChanged = false;
+        // Итоги, выданные распознавателем до конца фразы по собственному определению паузы
+        std::string pendingText;
+        std::vector<std::string> pendingJson;   // Исходные JSON этих итогов: слова с conf и временем
+        double confidenceSum = 0.0;
+        size_t words = 0;
+        FanoutBranchStats stats;
+    };
+
+    void branchLoop(Branch* branch);
+    void flush();
+    void releaseBlock(AudioBlock* block);
+    void collect(Branch* branch, const char* json);
+    // JSON итога фразы из итогов ветви
+    static std::string mergeResults(const std::string& text, const std::vector<std::string>& results);
+
+    std::vector<std::unique_ptr<Branch>> branches;
+    ResultHandler handler;
+    bool running;
+
+    // Пул блоков: не больше maxQueuedBlocks в очереди каждой ветви, по блоку в работе у каждой и текущий
+    std::unique_ptr<AudioBlock[]> blocks;
+    std::vector<AudioBlock*> freeBlocks;    // Ёмкость выделена заранее
+    std::mutex poolMutex;
+    AudioBlock* current;                // Заполняется в push()
+    size_t maxQueuedBlocks;
+};
+
+#endif // FANOUT_H
@@ -0,0 +1,428 @@
+#include "fuzzymatcher.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+#define MAX_TOKENS 64
+#define MAX_WORD_CANDIDATES 64
+
+namespace {
+
+// Группы согласных, в которых звук выпадает или сливается
+const struct {
+    const char* from;
+    const char* to;
+} CLUSTERS[] = {
+    {"вств", "ств"}, {"стн", "сн"},   {"здн", "зн"},   {"стл", "сл"},   {"лнц", "нц"},
+    {"ндск", "нск"}, {"нтск", "нск"}, {"рдц", "рц"},   {"ться", "ца"},  {"тся", "ца"},
+    {"сч", "щ"},     {"зч", "щ"},     {"жч", "щ"},
+};
+
+// Код буквы а..я (U+0430..U+044F): гласные сведены к трём классам (безударные о/а и е/и не различаются),
+// согласные — каждая своим кодом, 0 — буква не произносится
+const char LETTER_CODES[32] = {
+    'A', 'B', 'V', 'G', 'D', 'I', 'J', 'Z',     // а б в г д е ж з
+    'I', 'I', 'K', 'L', 'M', 'N', 'A', 'P',     // и й к л м н о п
+    'R', 'S', 'T', 'U', 'F', 'H', 'C', 'X',     // р с т у ф х ц ч
+    'W', 'Q', 0,   'I', 0,   'I', 'U', 'A',     // ш щ ъ ы ь э ю я
+};
+
+inline bool isVoiced(char code)
+{
+    return code == 'B' || code == 'V' || code == 'G' || code == 'D' || code == 'J' || code == 'Z';
+}
+
+inline bool isVoiceless(char code)
+{
+    return code == 'P' || code == 'F' || code == 'K' || code == 'T' || code == 'W' || code == 'S' ||
+           code == 'H' || code == 'C' || code == 'X' || code == 'Q';
+}
+
+inline char devoice(char code)
+{
+    switch (code) {
+    case 'B': return 'P';
+    case 'V': return 'F';
+    case 'G': return 'K';
+    case 'D': return 'T';
+    case 'J': return 'W';
+    case 'Z': return 'S';
+    default: return code;
+    }
+}
+
+// Код одного символа UTF-8 с позиции i; i сдвигается за символ
+char letterCode(std::string_view text, size_t& i)
+{
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    if (c < 0x80) {
+        ++i;
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) return static_cast<char>(c);
+        return 0;
+    }
+    if ((c == 0xD0 || c == 0xD1) && i + 1 < text.size()) {
+        unsigned int codepoint = ((c & 0x1Fu) << 6) | (static_cast<unsigned char>(text[i + 1]) & 0x3Fu);
+        i += 2;
+        if (codepoint >= 0x430 && codepoint <= 0x44F) return LETTER_CODES[codepoint - 0x430];
+        if (codepoint == 0x451) return 'I';    // ё, если текст не свёрнут
+        return 0;
+    }
+    // Прочие многобайтовые символы пропускаются целиком
+    ++i;
+    while (i < text.size() && (static_cast<unsigned char>(text[i]) & 0xC0) == 0x80) {
+        ++i;
+    }
+    return 0;
+}
+
+inline uint64_t hashSkipping(const char* text, size_t length, size_t skipA, size_t skipB)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < length; ++i) {
+        if (i == skipA || i == skipB) continue;
+        hash = (hash ^ static_cast<unsigned char>(text[i])) * FNV_PRIME;
+    }
+    // Длина в хэше разводит варианты разной длины с одинаковыми байтами
+    return hash ^ (length - (skipA < length) - (skipB < length));
+}
+
+// Хэши всех вариантов слова без не более чем depth символов
+template <typename Visit>
+void forEachDeletion(const char* text, size_t length, int depth, Visit visit)
+{
+    const size_t none = static_cast<size_t>(-1);
+    visit(hashSkipping(text, length, none, none));
+    if (depth < 1) return;
+    for (size_t i = 0; i < length; ++i) {
+        visit(hashSkipping(text, length, i, none));
+        if (depth < 2) continue;
+        for (size_t j = i + 1; j < length; ++j) {
+            visit(hashSkipping(text, length, i, j));
+        }
+    }
+}
+
+// Битовые маски позиций символов образца для алгоритма Майерса
+struct Pattern {
+    uint64_t peq[256];
+    size_t length;
+
+    // Образец для сравнения с любыми словами
+    void assign(std::string_view text)
+    {
+        std::memset(peq, 0, sizeof(peq));
+        setBits(text);
+    }
+
+    // Образец только для сравнения с other: обнуляются лишь маски символов обеих строк
+    void assignFor(std::string_view text, std::string_view other)
+    {
+        for (unsigned char c : other) {
+            peq[c] = 0;
+        }
+        for (unsigned char c : text) {
+            peq[c] = 0;
+        }
+        setBits(text);
+    }
+
+    void setBits(std::string_view text)
+    {
+        length = std::min(text.size(), static_cast<size_t>(64));
+        for (size_t i = 0; i < length; ++i) {
+            peq[static_cast<unsigned char>(text[i])] |= 1ull << i;
+        }
+    }
+
+    // Расстояние Левенштейна от образца до text: столбцы матрицы ДП хранятся разностями
+    // соседних ячеек в битах (Pv/Mv — +1/-1 по вертикали), один символ текста — десяток операций
+    int distance(std::string_view text) const
+    {
+        if (length == 0) return static_cast<int>(text.size());
+        uint64_t pv = ~0ull;
+        uint64_t mv = 0;
+        uint64_t last = 1ull << (length - 1);
+        int score = static_cast<int>(length);
+        for (unsigned char c : text) {
+            uint64_t eq = peq[c];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if (ph & last) {
+                ++score;
+            } else if (mh & last) {
+                --score;
+            }
+            // Верхняя строка матрицы растёт на 1 с каждым символом — глобальное выравнивание
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+        return score;
+    }
+};
+
+} // namespace
+
+FuzzyMatcher::FuzzyMatcher()
+    : deletionCountValue(0)
+    , threshold(0.0)
+{
+}
+
+void FuzzyMatcher::clear()
+{
+    phraseWords.clear();
+    phrases.clear();
+    vocabulary.clear();
+    phraseWordIds.clear();
+    startsStart.clear();
+    starts.clear();
+    deletions.clear();
+    deletionCountValue = 0;
+}
+
+size_t FuzzyMatcher::phonetic(std::string_view word, char* out, size_t capacity)
+{
+    // Сначала упрощаются группы согласных, потом буквы переводятся в коды
+    char codes[128];
+    size_t count = 0;
+    size_t i = 0;
+    while (i < word.size() && count < sizeof(codes)) {
+        bool replaced = false;
+        for (const auto& cluster : CLUSTERS) {
+            std::string_view from(cluster.from);
+            if (word.compare(i, from.size(), from) == 0) {
+                std::string_view to(cluster.to);
+                for (size_t j = 0; j < to.size() && count < sizeof(codes);) {
+                    char code = letterCode(to, j);
+                    if (code) codes[count++] = code;
+                }
+                i += from.size();
+                replaced = true;
+                break;
+            }
+        }
+        if (replaced) continue;
+        char code = letterCode(word, i);
+        if (code) codes[count++] = code;
+    }
+
+    // Звонкие оглушаются на конце слова и перед глухими; повторы сливаются
+    size_t length = 0;
+    for (size_t k = 0; k < count && length < capacity; ++k) {
+        char code = codes[k];
+        if (isVoiced(code) && (k + 1 == count || isVoiceless(codes[k + 1]))) {
+            code = devoice(code);
+        }
+        if (length > 0 && out[length - 1] == code) continue;
+        out[length++] = code;
+    }
+    return length;
+}
+
+int FuzzyMatcher::distance(std::string_view a, std::string_view b)
+{
+    Pattern pattern;
+    pattern.assignFor(a, b);
+    return pattern.distance(b);
+}
+
+int FuzzyMatcher::allowedEdits(size_t length) const
+{
+    return std::min(MaxEdits, static_cast<int>(static_cast<double>(length) * threshold + 1e-9));
+}
+
+void FuzzyMatcher::add(std::string_view keyword, int command, int priority)
+{
+    std::vector<std::string> words;
+    uint32_t length = 0;
+    size_t start = 0;
+    while (start < keyword.size()) {
+        size_t end = keyword.find(' ', start);
+        if (end == std::string_view::npos) end = keyword.size();
+        char code[MaxWordLength];
+        size_t codeLength = phonetic(keyword.substr(start, end - start), code, sizeof(code));
+        // Слово без кода (ь, ъ, цифры, латиница) нечётко не сравнить, а номера слов фразы и текста
+        // должны совпадать — такая фраза ищется только точным автоматом
+        if (codeLength == 0) return;
+        words.emplace_back(code, codeLength);
+        length += static_cast<uint32_t>(codeLength);
+        start = end + 1;
+    }
+    if (words.empty() || words.size() > MaxPhraseWords) return;
+
+    phrases.push_back(Phrase{command, priority, static_cast<uint32_t>(phrases.size()),
+                             static_cast<uint32_t>(words.size()), length, 0});
+    phraseWords.push_back(std::move(words));
+}
+
+void FuzzyMatcher::build(double editThreshold)
+{
+    threshold = editThreshold;
+    vocabulary.clear();
+    phraseWordIds.clear();
+    startsStart.clear();
+    starts.clear();
+    deletions.clear();
+
+    std::unordered_map<std::string, uint32_t> index;
+    std::vector<std::vector<uint32_t>> wordStarts;
+    for (size_t p = 0; p < phraseWords.size(); ++p) {
+        phrases[p].firstWord = static_cast<uint32_t>(phraseWordIds.size());
+        for (const auto& word : phraseWords[p]) {
+            auto inserted = index.emplace(word, static_cast<uint32_t>(vocabulary.size()));
+            if (inserted.second) {
+                vocabulary.push_back(word);
+                wordStarts.emplace_back();
+            }
+            phraseWordIds.push_back(inserted.first->second);
+        }
+        wordStarts[phraseWordIds[phrases[p].firstWord]].push_back(static_cast<uint32_t>(p));
+    }
+
+    startsStart.reserve(vocabulary.size() + 1);
+    for (const auto& list : wordStarts) {
+        startsStart.push_back(static_cast<uint32_t>(starts.size()));
+        starts.insert(starts.end(), list.begin(), list.end());
+    }
+    startsStart.push_back(static_cast<uint32_t>(starts.size()));
+
+    // Окрестность удалений словаря: слово на расстоянии d от запроса даёт с ним общий вариант
+    // не более чем после d удалений с каждой стороны
+    std::vector<Deletion> variants;
+    for (uint32_t w = 0; w < vocabulary.size(); ++w) {
+        const std::string& word = vocabulary[w];
+        forEachDeletion(word.data(), word.size(), allowedEdits(word.size()), [&variants, w](uint64_t hash) {
+            variants.push_back(Deletion{hash, w + 1});
+        });
+    }
+    std::sort(variants.begin(), variants.end(), [](const Deletion& a, const Deletion& b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.word < b.word;
+    });
+    variants.erase(std::unique(variants.begin(), variants.end(), [](const Deletion& a, const Deletion& b) {
+        return a.hash == b.hash && a.word == b.word;
+    }), variants.end());
+    deletionCountValue = variants.size();
+
+    // Линейное пробирование, заполнение не больше половины: запрос — одно-два чтения подряд
+    size_t capacity = 16;
+    while (capacity < variants.size() * 2) {
+        capacity *= 2;
+    }
+    deletions.assign(capacity, Deletion{0, 0});
+    for (const auto& variant : variants) {
+        size_t slot = variant.hash & (capacity - 1);
+        while (deletions[slot].word != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        deletions[slot] = variant;
+    }
+}
+
+bool FuzzyMatcher::match(std::string_view text, FuzzyMatch& match) const
+{
+    match = FuzzyMatch();
+    if (deletionCountValue == 0) return false;
+    const size_t mask = deletions.size() - 1;
+
+    // Слова словаря, найденные для каждого слова текста, с расстоянием
+    struct WordHit {
+        uint32_t word;
+        int distance;
+    };
+    struct TokenHits {
+        WordHit hits[MAX_WORD_CANDIDATES];
+        size_t count;
+
+        int distanceTo(uint32_t word) const
+        {
+            for (size_t i = 0; i < count; ++i) {
+                if (hits[i].word == word) return hits[i].distance;
+            }
+            return -1;
+        }
+    };
+    TokenHits tokens[MAX_TOKENS];
+    size_t tokenCount = 0;
+
+    Pattern pattern;
+    int queryDepth = allowedEdits(MaxWordLength);
+    size_t start = 0;
+    while (start < text.size() && tokenCount < MAX_TOKENS) {
+        size_t end = text.find(' ', start);
+        if (end == std::string_view::npos) end = text.size();
+        char code[MaxWordLength];
+        size_t codeLength = phonetic(text.substr(start, end - start), code, sizeof(code));
+        start = end + 1;
+
+        // Номер токена — номер слова текста (CommandScorer ищет по нему границы совпадения).
+        // Слово без кода остаётся токеном без кандидатов: фраза через него не совпадёт
+        TokenHits& token = tokens[tokenCount++];
+        token.count = 0;
+        if (codeLength == 0) continue;
+        pattern.assign(std::string_view(code, codeLength));
+        // Слова, уже проверенные для этого слова текста (в том числе отвергнутые)
+        uint32_t checked[MAX_WORD_CANDIDATES];
+        size_t checkedCount = 0;
+        forEachDeletion(code, codeLength, queryDepth, [&](uint64_t hash) {
+            for (size_t slot = hash & mask; deletions[slot].word != 0; slot = (slot + 1) & mask) {
+                if (deletions[slot].hash != hash) continue;
+                uint32_t w = deletions[slot].word - 1;
+                if (std::find(checked, checked + checkedCount, w) != checked + checkedCount) continue;
+                if (checkedCount == MAX_WORD_CANDIDATES) return;
+                checked[checkedCount++] = w;
+
+                const std::string& word = vocabulary[w];
+                int allowed = allowedEdits(word.size());
+                size_t longer = std::max(word.size(), codeLength);
+                size_t shorter = std::min(word.size(), codeLength);
+                if (longer - shorter > static_cast<size_t>(allowed)) continue;
+                int d = pattern.distance(word);
+                if (d <= allowed) {
+                    token.hits[token.count++] = WordHit{w, d};
+                }
+            }
+        });
+    }
+
+    // Фраза-кандидат появляется по первому слову, остальные её слова должны идти следом
+    const Phrase* best = nullptr;
+    for (size_t i = 0; i < tokenCount; ++i) {
+        const TokenHits& token = tokens[i];
+        for (size_t h = 0; h < token.count; ++h) {
+            uint32_t w = token.hits[h].word;
+            for (uint32_t s = startsStart[w]; s < startsStart[w + 1]; ++s) {
+                const Phrase& phrase = phrases[starts[s]];
+                if (i + phrase.wordCount > tokenCount) continue;
+                if (best && phrase.length < best->length) continue;
+
+                int total = token.hits[h].distance;
+                for (uint32_t j = 1; j < phrase.wordCount && total >= 0; ++j) {
+                    int d = tokens[i + j].distanceTo(phraseWordIds[phrase.firstWord + j]);
+                    total = d < 0 ? -1 : total + d;
+                }
+                if (total < 0) continue;
+
+                bool better = !best || phrase.length > best->length || total < match.distance ||
+                              (total == match.distance &&
+                               (phrase.priority > best->priority ||
+                                (phrase.priority == best->priority && phrase.order < best->order)));
+                if (better) {
+                    best = &phrase;
+                    match.command = phrase.command;
+                    match.priority = phrase.priority;
+                    match.distance = total;
+                    match.length = phrase.length;
+                    match.firstWord = i;
+                    match.wordCount = phrase.wordCount;
+                }
+            }
+        }
+    }
+    return best != nullptr;
+}
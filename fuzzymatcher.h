@@ -0,0 +1,84 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Нечёткое совпадение ключевой фразы
+struct FuzzyMatch {
+    int command = -1;
+    int priority = 0;
+    int distance = 0;                   // Сумма расстояний Левенштейна по словам фразы (в звуках)
+    size_t length = 0;                  // Длина фразы в звуках
+    size_t firstWord = 0;               // Слова текста [firstWord, firstWord + wordCount), считая слова без кода
+    size_t wordCount = 0;
+};
+
+// Нечёткий поиск ключевых фраз по словам: каждое слово фразы и текста переводится
+// в фонетический код (редукция гласных, оглушение, упрощение групп согласных),
+// и слова сравниваются по расстоянию Левенштейна.
+// Кандидаты из словаря находятся по окрестности удалений (до MaxEdits удалений с обеих сторон,
+// поиск без перебора словаря), а расстояние проверяется битово-параллельным алгоритмом
+// Майерса в варианте Хююрё. Фраза совпадает, если её слова подряд нашлись в тексте:
+// кандидаты фраз берутся только по первому слову, остальные слова проверяются по найденным.
+class FuzzyMatcher
+{
+public:
+    static constexpr int MaxEdits = 2;
+    static constexpr size_t MaxWordLength = 63;     // Длиннее — только точное совпадение кода
+    static constexpr size_t MaxPhraseWords = 16;
+
+    FuzzyMatcher();
+
+    void clear();
+    // Фраза должна быть свёрнута (foldText), как и текст для match(). Фраза со словом без
+    // фонетического кода (цифры, латиница, одни ь и ъ) не добавляется — её найдёт только точный поиск
+    void add(std::string_view keyword, int command, int priority = 0);
+    // threshold — допустимая доля правок на слово (0.3: слову из 7 звуков прощаются 2 ошибки)
+    void build(double threshold);
+
+    // Лучшее совпадение: длиннее фраза, затем меньше расстояние, затем выше приоритет, затем раньше добавлена
+    bool match(std::string_view text, FuzzyMatch& match) const;
+
+    size_t keywordCount() const { return phrases.size(); }
+    size_t vocabularySize() const { return vocabulary.size(); }
+    size_t deletionCount() const { return deletionCountValue; }
+
+    // Фонетический код слова (ASCII, не длиннее capacity); возвращает длину
+    static size_t phonetic(std::string_view word, char* out, size_t capacity);
+    // Расстояние Левенштейна между словами до 64 символов (битово-параллельно)
+    static int distance(std::string_view a, std::string_view b);
+
+private:
+    struct Phrase {
+        int command;
+        int priority;
+        uint32_t order;
+        uint32_t wordCount;
+        uint32_t length;
+        uint32_t firstWord;             // Слова фразы — phraseWordIds[firstWord, firstWord + wordCount)
+    };
+
+    // Ячейка открытой адресации: word = 0 — пусто, иначе номер слова + 1
+    struct Deletion {
+        uint64_t hash;
+        uint32_t word;
+    };
+
+    int allowedEdits(size_t length) const;
+
+    std::vector<std::vector<std::string>> phraseWords;  // Фонетические слова фраз до build()
+    std::vector<Phrase> phrases;
+    std::vector<std::string> vocabulary;            // Фонетические коды различных слов фраз
+    std::vector<uint32_t> phraseWordIds;            // Номера слов словаря по фразам
+    std::vector<uint32_t> startsStart;              // starts[startsStart[w], startsStart[w + 1]) —
+    std::vector<uint32_t> starts;                   // фразы, которые начинаются словом w
+    std::vector<Deletion> deletions;                // Хэш-таблица вариантов, размер — степень двойки
+    size_t deletionCountValue;
+    double threshold;
+};
+
+#endif // FUZZYMATCHER_H
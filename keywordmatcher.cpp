@@ -0,0 +1,141 @@
+#include "keywordmatcher.h"
+#include <cstring>
+#include <deque>
+
+#define HAS_OUTPUT 0x80000000u
+#define ROW_MASK 0x7FFFFFFFu
+#define NO_STATE 0xFFFFFFFFu
+
+KeywordMatcher::KeywordMatcher()
+    : classes(1)
+{
+    std::memset(classOf, 0, sizeof(classOf));
+}
+
+void KeywordMatcher::clear()
+{
+    keywords.clear();
+    table.clear();
+    outputs.clear();
+    std::memset(classOf, 0, sizeof(classOf));
+    classes = 1;
+}
+
+void KeywordMatcher::add(std::string_view keyword, int command, int priority)
+{
+    if (keyword.empty()) return;
+    keywords.push_back(Keyword{std::string(keyword), command, priority, keywords.size()});
+}
+
+bool KeywordMatcher::better(const Output& candidate, const Output& current)
+{
+    if (candidate.command < 0) return false;
+    if (current.command < 0) return true;
+    if (candidate.length != current.length) return candidate.length > current.length;
+    if (candidate.priority != current.priority) return candidate.priority > current.priority;
+    return candidate.order < current.order;
+}
+
+void KeywordMatcher::build()
+{
+    table.clear();
+    outputs.clear();
+    std::memset(classOf, 0, sizeof(classOf));
+
+    // Класс 0 — байты, которых нет в ключевых словах
+    classes = 1;
+    for (const auto& keyword : keywords) {
+        for (unsigned char c : keyword.text) {
+            if (classOf[c] == 0) {
+                classOf[c] = static_cast<uint8_t>(classes++);
+            }
+        }
+    }
+
+    // Бор: строки таблицы добавляются по мере появления состояний
+    table.assign(classes, NO_STATE);
+    outputs.resize(1);
+    for (const auto& keyword : keywords) {
+        uint32_t state = 0;
+        for (unsigned char c : keyword.text) {
+            size_t edge = state * classes + classOf[c];
+            if (table[edge] == NO_STATE) {
+                table[edge] = static_cast<uint32_t>(outputs.size());
+                outputs.emplace_back();
+                table.resize(table.size() + classes, NO_STATE);
+            }
+            state = table[edge];
+        }
+        Output own;
+        own.command = keyword.command;
+        own.priority = keyword.priority;
+        own.length = static_cast<uint32_t>(keyword.text.size());
+        own.order = static_cast<uint32_t>(keyword.order);
+        if (better(own, outputs[state])) {
+            outputs[state] = own;
+        }
+    }
+
+    // Обход в ширину: недостающие переходы берутся из состояния по ссылке неудачи,
+    // которое ближе к корню и уже достроено
+    std::vector<uint32_t> fail(outputs.size(), 0);
+    std::deque<uint32_t> queue;
+    for (uint32_t c = 0; c < classes; ++c) {
+        uint32_t& next = table[c];
+        if (next == NO_STATE) {
+            next = 0;
+        } else {
+            queue.push_back(next);
+        }
+    }
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+        const Output& suffix = outputs[fail[state]];
+        if (better(suffix, outputs[state])) {
+            outputs[state] = suffix;
+        }
+        for (uint32_t c = 0; c < classes; ++c) {
+            uint32_t& next = table[state * classes + c];
+            uint32_t fallback = table[fail[state] * classes + c];
+            if (next == NO_STATE) {
+                next = fallback;
+            } else {
+                fail[next] = fallback;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    // Номера состояний заменяются на смещения строк, признак выхода — в старший бит
+    for (auto& next : table) {
+        next = next * classes | (outputs[next].command >= 0 ? HAS_OUTPUT : 0);
+    }
+}
+
+bool KeywordMatcher::match(std::string_view text, KeywordMatch& match) const
+{
+    match = KeywordMatch();
+    if (table.empty()) return false;
+
+    const uint32_t* rows = table.data();
+    const Output* best = nullptr;
+    uint32_t row = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t next = rows[row + classOf[static_cast<unsigned char>(text[i])]];
+        row = next & ROW_MASK;
+        if (next & HAS_OUTPUT) {
+            const Output& output = outputs[row / classes];
+            if (!best || better(output, *best)) {
+                best = &output;
+                match.end = i + 1;
+            }
+        }
+    }
+
+    if (!best) return false;
+    match.command = best->command;
+    match.priority = best->priority;
+    match.length = best->length;
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef KEYWORDMATCHER_H
+#define KEYWORDMATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Найденное ключевое слово
+struct KeywordMatch {
+    int command = -1;                   // Номер, переданный в add()
+    int priority = 0;
+    size_t length = 0;                  // Длина ключевого слова в байтах
+    size_t end = 0;                     // Конец совпадения в тексте
+};
+
+// Автомат Ахо–Корасик по ключевым словам всех команд.
+// Переходы заранее достроены по ссылкам неудач и лежат одной плоской таблицей
+// [состояние × класс байта]: на каждый байт текста приходится одно чтение из таблицы.
+// Байты, которых нет ни в одном ключевом слове, делят общий класс, поэтому строка таблицы короткая.
+// Из нескольких совпадений выигрывает самое длинное, затем с большим приоритетом,
+// затем добавленное раньше.
+class KeywordMatcher
+{
+public:
+    KeywordMatcher();
+
+    void clear();
+    // Ключевое слово должно быть уже свёрнуто (foldText), как и текст для match()
+    void add(std::string_view keyword, int command, int priority = 0);
+    // Строит таблицу переходов; до вызова match() ничего не находит
+    void build();
+
+    bool match(std::string_view text, KeywordMatch& match) const;
+
+    size_t keywordCount() const { return keywords.size(); }
+    size_t stateCount() const { return outputs.size(); }
+    size_t classCount() const { return classes; }
+    size_t tableBytes() const { return table.size() * sizeof(uint32_t) + outputs.size() * sizeof(Output); }
+
+private:
+    struct Keyword {
+        std::string text;
+        int command;
+        int priority;
+        size_t order;
+    };
+
+    // Лучшее ключевое слово, заканчивающееся в состоянии (с учётом суффиксов)
+    struct Output {
+        int command = -1;
+        int priority = 0;
+        uint32_t length = 0;
+        uint32_t order = 0;
+    };
+
+    static bool better(const Output& candidate, const Output& current);
+
+    std::vector<Keyword> keywords;
+    uint8_t classOf[256];
+    uint32_t classes;
+    // Переход: номер следующего состояния, умноженный на classes (начало его строки);
+    // старший бит — в состоянии заканчивается ключевое слово
+    std::vector<uint32_t> table;
+    std::vector<Output> outputs;
+};
+
+#endif // KEYWORDMATCHER_H
@@ -1,10 +1,30 @@
 #include <QApplication>
+#include <QCoreApplication>
+#include <QSettings>
 #include "mainwindow.h"
+#include "modelprewarm.h"
+#include "batchtranscriber.h"
+#include "voiceassistant.h"
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // Пакетное распознавание файлов работает без графического интерфейса
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            QCoreApplication app(argc, argv);
+            return runBatchMode(app.arguments());
+        }
+    }
+
     QApplication app(argc, argv);
-    
+
+    // Файлы модели подтягиваются в кэш страниц, пока строится интерфейс
+    QSettings settings("VoiceAssistant", "GUI");
+    if (settings.value("model/prewarm", true).toBool()) {
+        ModelPrewarmer::instance().start(findModelPath(), settings.value("model/lockInMemory", false).toBool());
+    }
+
     MainWindow window;
     window.show();
     
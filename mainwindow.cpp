@@ -25,6 +25,7 @@ MainWindow::MainWindow(QWidget *parent)
     , autoStartCheckBox(nullptr)
     , statusLabel(nullptr)
     , startStopAction(nullptr)
+    , releaseModelAction(nullptr)
     , quitAction(nullptr)
     , showAction(nullptr)
     , installButton(nullptr) // Инициализация новых кнопок
@@ -78,7 +79,8 @@ void MainWindow::closeEvent(QCloseEvent *event)
 // --- Слоты ---
 void MainWindow::onStartStopClicked()
 {
-    if (voiceAssistant->isRunning()) {
+    // Нажатие во время загрузки модели отменяет её
+    if (voiceAssistant->isRunning() || voiceAssistant->isLoading()) {
         voiceAssistant->stop();
     } else {
         voiceAssistant->start();
@@ -152,6 +154,11 @@ void MainWindow::updateStatus()
         statusLabel->setStyleSheet("QLabel { color: green; font-weight: bold; }");
         startStopButton->setText("Остановить");
         startStopAction->setText("Остановить");
+    } else if (voiceAssistant->isLoading()) {
+        statusLabel->setText("Статус: Загрузка модели...");
+        statusLabel->setStyleSheet("QLabel { color: orange; font-weight: bold; }");
+        startStopButton->setText("Отменить");
+        startStopAction->setText("Отменить");
     } else {
         statusLabel->setText("Статус: Остановлен");
         statusLabel->setStyleSheet("QLabel { color: red; font-weight: bold; }");
@@ -250,11 +257,15 @@ void MainWindow::createTrayIcon()
         activateWindow();
     });
 
+    releaseModelAction = new QAction("Выгрузить модель из памяти", this);
+    connect(releaseModelAction, &QAction::triggered, voiceAssistant, &VoiceAssistant::releaseModel);
+
     quitAction = new QAction("Выход", this);
     connect(quitAction, &QAction::triggered, qApp, &QApplication::quit);
 
     trayIconMenu->addAction(startStopAction);
     trayIconMenu->addAction(showAction);
+    trayIconMenu->addAction(releaseModelAction);
     trayIconMenu->addSeparator();
     trayIconMenu->addAction(quitAction);
 
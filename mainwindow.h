@@ -73,6 +73,7 @@ private:
     QCheckBox *autoStartCheckBox; // Этот чекбокс теперь управляет и автозапуском приложения
     QLabel *statusLabel;
     QAction *startStopAction;
+    QAction *releaseModelAction;
     QAction *quitAction;
     QAction *showAction;
     
@@ -0,0 +1,169 @@
+#include "modelcache.h"
+
+ModelCache& ModelCache::instance()
+{
+    static ModelCache cache;
+    return cache;
+}
+
+ModelCache::ModelCache()
+    : keepResident(true)
+    , idleTimeout(300)
+    , shuttingDown(false)
+{
+    evictor = std::thread(&ModelCache::evictionLoop, this);
+}
+
+ModelCache::~ModelCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    wake.notify_all();
+    if (evictor.joinable()) {
+        evictor.join();
+    }
+
+    for (auto& item : entries) {
+        if (item.second.model) {
+            vosk_model_free(item.second.model);
+        }
+    }
+}
+
+void ModelCache::configure(bool resident, std::chrono::seconds timeout)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    keepResident = resident;
+    idleTimeout = timeout;
+}
+
+VoskModel* ModelCache::acquire(const std::string& path, bool* fromCache)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Одновременный запрос той же модели дожидается её, а не загружает вторую копию.
+    // Если загрузка не удалась, запись исчезает и следующий ожидающий пробует сам
+    auto it = entries.find(path);
+    while (it != entries.end() && it->second.loading) {
+        loaded.wait(lock);
+        it = entries.find(path);
+    }
+    if (it != entries.end()) {
+        if (fromCache) {
+            *fromCache = true;
+        }
+        ++it->second.refs;
+        it->second.evictionScheduled = false;
+        return it->second.model;
+    }
+
+    // Запись в состоянии загрузки не трогают ни purge(), ни выгрузка по таймауту
+    Entry& entry = entries[path];
+    entry.loading = true;
+    lock.unlock();
+    VoskModel* model = vosk_model_new(path.c_str());
+    lock.lock();
+
+    entry.loading = false;
+    loaded.notify_all();
+    if (fromCache) {
+        *fromCache = false;
+    }
+    if (!model) {
+        entries.erase(path);
+        return nullptr;
+    }
+    entry.model = model;
+    ++entry.refs;
+    entry.evictionScheduled = false;
+    return model;
+}
+
+void ModelCache::release(VoskModel* model)
+{
+    if (!model) return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        Entry& entry = it->second;
+        if (entry.model != model) continue;
+
+        if (--entry.refs > 0) return;
+
+        if (!keepResident) {
+            entries.erase(it);
+            lock.unlock();
+            vosk_model_free(model);
+        } else if (idleTimeout.count() > 0) {
+            entry.evictionScheduled = true;
+            entry.evictAt = std::chrono::steady_clock::now() + idleTimeout;
+            wake.notify_all();
+        }
+        return;
+    }
+}
+
+int ModelCache::purge()
+{
+    // Модели освобождаются после снятия блокировки: кэш в это время продолжает выдавать остальные
+    std::vector<VoskModel*> unused;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.refs == 0 && !it->second.loading) {
+                unused.push_back(it->second.model);
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (VoskModel* model : unused) {
+        vosk_model_free(model);
+    }
+    return static_cast<int>(unused.size());
+}
+
+void ModelCache::evictionLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shuttingDown) {
+        auto now = std::chrono::steady_clock::now();
+        bool haveDeadline = false;
+        std::chrono::steady_clock::time_point nearest;
+
+        std::vector<VoskModel*> expired;
+        for (auto it = entries.begin(); it != entries.end();) {
+            Entry& entry = it->second;
+            if (entry.refs == 0 && entry.evictionScheduled) {
+                if (entry.evictAt <= now) {
+                    expired.push_back(entry.model);
+                    it = entries.erase(it);
+                    continue;
+                }
+                if (!haveDeadline || entry.evictAt < nearest) {
+                    nearest = entry.evictAt;
+                    haveDeadline = true;
+                }
+            }
+            ++it;
+        }
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (VoskModel* model : expired) {
+                vosk_model_free(model);
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (haveDeadline) {
+            wake.wait_until(lock, nearest);
+        } else {
+            wake.wait(lock);
+        }
+    }
+}
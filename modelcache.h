@@ -0,0 +1,62 @@
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include "vosk_api.h"
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Общий на процесс кэш загруженных моделей Vosk.
+// Остановка ассистента только отпускает модель; повторный запуск создаёт лишь
+// дешёвый VoskRecognizer. Неиспользуемая модель выгружается по таймауту простоя
+// или явным вызовом purge().
+class ModelCache
+{
+public:
+    static ModelCache& instance();
+
+    // keepResident = false — выгружать модель сразу после последнего release()
+    // idleTimeout = 0 — держать в памяти, пока не вызван purge()
+    void configure(bool keepResident, std::chrono::seconds idleTimeout);
+
+    // Возвращает модель (загружая её при необходимости) и увеличивает счётчик ссылок.
+    // В *fromCache пишется, была ли модель уже загружена. Загрузка идёт без блокировки кэша:
+    // другие модели выдаются и выгружаются тем временем, запрос той же модели ждёт её загрузки.
+    VoskModel* acquire(const std::string& path, bool* fromCache = nullptr);
+    void release(VoskModel* model);
+
+    // Выгружает все модели без ссылок, возвращает их число. Освобождение памяти модели занимает время —
+    // не вызывать из потока интерфейса
+    int purge();
+
+private:
+    struct Entry {
+        VoskModel* model = nullptr;
+        int refs = 0;
+        bool loading = false;           // vosk_model_new идёт в потоке первого запросившего
+        bool evictionScheduled = false;
+        std::chrono::steady_clock::time_point evictAt;
+    };
+
+    ModelCache();
+    ~ModelCache();
+    ModelCache(const ModelCache&) = delete;
+    ModelCache& operator=(const ModelCache&) = delete;
+
+    void evictionLoop();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable loaded;     // Конец загрузки какой-либо модели
+    std::map<std::string, Entry> entries;
+    bool keepResident;
+    std::chrono::seconds idleTimeout;
+    bool shuttingDown;
+    std::thread evictor;
+};
+
+#endif // MODELCACHE_H
@@ -0,0 +1,154 @@
+#include "modelprewarm.h"
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ModelPrewarmer& ModelPrewarmer::instance()
+{
+    static ModelPrewarmer prewarmer;
+    return prewarmer;
+}
+
+ModelPrewarmer::ModelPrewarmer()
+    : started(false)
+{
+}
+
+ModelPrewarmer::~ModelPrewarmer()
+{
+    if (worker.joinable()) {
+        worker.join();
+    }
+    unlock();
+}
+
+void ModelPrewarmer::start(const std::string& modelPath, bool lockHotFiles)
+{
+    if (modelPath.empty() || started.exchange(true)) return;
+    worker = std::thread(&ModelPrewarmer::run, this, modelPath, lockHotFiles);
+}
+
+PrewarmStats ModelPrewarmer::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return result;
+}
+
+void ModelPrewarmer::unlock()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& mapping : lockedMappings) {
+        munlock(mapping.first, mapping.second);
+        munmap(mapping.first, mapping.second);
+    }
+    lockedMappings.clear();
+    result.lockedFiles = 0;
+    result.lockedBytes = 0;
+}
+
+void ModelPrewarmer::collectFiles(const std::string& dir, std::vector<std::string>& files)
+{
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) return;
+
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+
+        std::string path = dir + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            collectFiles(path, files);
+        } else if (S_ISREG(st.st_mode)) {
+            files.push_back(path);
+        }
+    }
+    closedir(d);
+}
+
+// Файлы, которые vosk_model_new читает целиком: акустическая модель, граф и экстрактор i-векторов
+bool ModelPrewarmer::isHotFile(const std::string& path)
+{
+    static const char* hot[] = {"final.mdl", "HCLG.fst", "HCLr.fst", "Gr.fst", "final.ie"};
+    for (const char* name : hot) {
+        size_t len = std::char_traits<char>::length(name);
+        if (path.size() >= len && path.compare(path.size() - len, len, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ModelPrewarmer::lockFile(const std::string& path, uint64_t size)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Без CAP_IPC_LOCK предел RLIMIT_MEMLOCK обычно несколько мегабайт
+    if (mlock(addr, size) != 0) {
+        munmap(addr, size);
+        ++result.lockFailures;
+        return;
+    }
+    lockedMappings.emplace_back(addr, size);
+    ++result.lockedFiles;
+    result.lockedBytes += size;
+}
+
+void ModelPrewarmer::run(std::string modelPath, bool lockHotFiles)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::string> files;
+    collectFiles(modelPath, files);
+
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> bytes(0);
+    auto readFiles = [&]() {
+        size_t index;
+        while ((index = next.fetch_add(1)) < files.size()) {
+            const std::string& path = files[index];
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+                // readahead блокируется на время чтения — параллельные потоки держат очередь диска полной
+                readahead(fd, 0, static_cast<size_t>(st.st_size));
+                bytes += static_cast<uint64_t>(st.st_size);
+                if (lockHotFiles && isHotFile(path)) {
+                    lockFile(path, static_cast<uint64_t>(st.st_size));
+                }
+            }
+            close(fd);
+        }
+    };
+
+    unsigned int threadCount = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> readers;
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        readers.emplace_back(readFiles);
+    }
+    readFiles();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    result.files = files.size();
+    result.bytes = bytes;
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    result.finished = true;
+}
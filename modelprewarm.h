@@ -0,0 +1,58 @@
+#ifndef MODELPREWARM_H
+#define MODELPREWARM_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Итог прогрева
+struct PrewarmStats {
+    bool finished = false;
+    size_t files = 0;
+    uint64_t bytes = 0;
+    double elapsedMs = 0.0;
+    size_t lockedFiles = 0;
+    uint64_t lockedBytes = 0;
+    size_t lockFailures = 0;
+};
+
+// Прогрев файлов модели в кэше страниц до vosk_model_new.
+// Запускается из main() и идёт параллельно с построением интерфейса: файлы каталога
+// модели открываются в нескольких потоках, для каждого вызывается posix_fadvise(WILLNEED)
+// и readahead(). Самые нужные файлы можно закрепить в памяти через mlock.
+class ModelPrewarmer
+{
+public:
+    static ModelPrewarmer& instance();
+
+    void start(const std::string& modelPath, bool lockHotFiles);
+    bool isStarted() const { return started; }
+    PrewarmStats stats() const;
+
+    // Снимает mlock и освобождает отображения
+    void unlock();
+
+private:
+    ModelPrewarmer();
+    ~ModelPrewarmer();
+    ModelPrewarmer(const ModelPrewarmer&) = delete;
+    ModelPrewarmer& operator=(const ModelPrewarmer&) = delete;
+
+    void run(std::string modelPath, bool lockHotFiles);
+    void collectFiles(const std::string& dir, std::vector<std::string>& files);
+    static bool isHotFile(const std::string& path);
+    void lockFile(const std::string& path, uint64_t size);
+
+    std::atomic<bool> started;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    PrewarmStats result;
+    std::vector<std::pair<void*, size_t>> lockedMappings;
+};
+
+#endif // MODELPREWARM_H
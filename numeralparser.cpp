@@ -0,0 +1,307 @@
+#include "numeralparser.h"
+#include <cmath>
+#include <cstring>
+
+// Слотов хэш-таблицы слов (степень двойки, заполнение меньше половины)
+#define WORD_TABLE_SIZE 512
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+// Больше цифр не поместится в int64_t после умножения на миллион: 10^12 * 10^6 < 2^63
+#define MAX_DIGITS 12
+// Длительность длиннее века — ошибка распознавания; заодно держит секунды далеко от границы int64_t
+#define MAX_DURATION_SECONDS (100.0 * 366 * 86400)
+
+namespace {
+
+enum WordKind : uint8_t {
+    KIND_ZERO,
+    KIND_UNITS,                         // 1–9
+    KIND_TEENS,                         // 10–19
+    KIND_TENS,                          // 20–90
+    KIND_HUNDREDS,                      // 100–900
+    KIND_MULTIPLIER,                    // тысяча, миллион
+    KIND_HALF,                          // пол (часа)
+    KIND_ONE_AND_HALF,                  // полтора
+    KIND_TIME_UNIT,                     // value — секунды
+    KIND_AND,                           // связка "и"
+    KIND_WITH,                          // "с" (половиной)
+    KIND_HALF_NOUN                      // "половиной"
+};
+
+struct WordEntry {
+    const char* word;
+    WordKind kind;
+    int32_t value;
+};
+
+// Именительный и винительный падежи ("на пять минут", "одну секунду") и частые косвенные формы
+const WordEntry WORDS[] = {
+    {"ноль", KIND_ZERO, 0}, {"нуль", KIND_ZERO, 0},
+    {"один", KIND_UNITS, 1}, {"одна", KIND_UNITS, 1}, {"одно", KIND_UNITS, 1}, {"одну", KIND_UNITS, 1},
+    {"одного", KIND_UNITS, 1}, {"одной", KIND_UNITS, 1},
+    {"два", KIND_UNITS, 2}, {"две", KIND_UNITS, 2}, {"двух", KIND_UNITS, 2},
+    {"три", KIND_UNITS, 3}, {"трех", KIND_UNITS, 3},
+    {"четыре", KIND_UNITS, 4}, {"четырех", KIND_UNITS, 4},
+    {"пять", KIND_UNITS, 5}, {"пяти", KIND_UNITS, 5},
+    {"шесть", KIND_UNITS, 6}, {"шести", KIND_UNITS, 6},
+    {"семь", KIND_UNITS, 7}, {"семи", KIND_UNITS, 7},
+    {"восемь", KIND_UNITS, 8}, {"восьми", KIND_UNITS, 8},
+    {"девять", KIND_UNITS, 9}, {"девяти", KIND_UNITS, 9},
+    {"десять", KIND_TEENS, 10}, {"десяти", KIND_TEENS, 10},
+    {"одиннадцать", KIND_TEENS, 11}, {"двенадцать", KIND_TEENS, 12}, {"тринадцать", KIND_TEENS, 13},
+    {"четырнадцать", KIND_TEENS, 14}, {"пятнадцать", KIND_TEENS, 15}, {"шестнадцать", KIND_TEENS, 16},
+    {"семнадцать", KIND_TEENS, 17}, {"восемнадцать", KIND_TEENS, 18}, {"девятнадцать", KIND_TEENS, 19},
+    {"двадцать", KIND_TENS, 20}, {"двадцати", KIND_TENS, 20},
+    {"тридцать", KIND_TENS, 30}, {"тридцати", KIND_TENS, 30},
+    {"сорок", KIND_TENS, 40}, {"сорока", KIND_TENS, 40},
+    {"пятьдесят", KIND_TENS, 50}, {"шестьдесят", KIND_TENS, 60}, {"семьдесят", KIND_TENS, 70},
+    {"восемьдесят", KIND_TENS, 80}, {"девяносто", KIND_TENS, 90},
+    {"сто", KIND_HUNDREDS, 100}, {"двести", KIND_HUNDREDS, 200}, {"триста", KIND_HUNDREDS, 300},
+    {"четыреста", KIND_HUNDREDS, 400}, {"пятьсот", KIND_HUNDREDS, 500}, {"шестьсот", KIND_HUNDREDS, 600},
+    {"семьсот", KIND_HUNDREDS, 700}, {"восемьсот", KIND_HUNDREDS, 800}, {"девятьсот", KIND_HUNDREDS, 900},
+    {"тысяча", KIND_MULTIPLIER, 1000}, {"тысячу", KIND_MULTIPLIER, 1000}, {"тысячи", KIND_MULTIPLIER, 1000},
+    {"тысяч", KIND_MULTIPLIER, 1000},
+    {"миллион", KIND_MULTIPLIER, 1000000}, {"миллиона", KIND_MULTIPLIER, 1000000},
+    {"миллионов", KIND_MULTIPLIER, 1000000},
+    {"пол", KIND_HALF, 0}, {"полтора", KIND_ONE_AND_HALF, 0}, {"полторы", KIND_ONE_AND_HALF, 0},
+    {"секунда", KIND_TIME_UNIT, 1}, {"секунду", KIND_TIME_UNIT, 1}, {"секунды", KIND_TIME_UNIT, 1},
+    {"секунд", KIND_TIME_UNIT, 1},
+    {"минута", KIND_TIME_UNIT, 60}, {"минуту", KIND_TIME_UNIT, 60}, {"минуты", KIND_TIME_UNIT, 60},
+    {"минут", KIND_TIME_UNIT, 60},
+    {"час", KIND_TIME_UNIT, 3600}, {"часа", KIND_TIME_UNIT, 3600}, {"часов", KIND_TIME_UNIT, 3600},
+    {"сутки", KIND_TIME_UNIT, 86400}, {"суток", KIND_TIME_UNIT, 86400},
+    {"день", KIND_TIME_UNIT, 86400}, {"дня", KIND_TIME_UNIT, 86400}, {"дней", KIND_TIME_UNIT, 86400},
+    {"и", KIND_AND, 0}, {"с", KIND_WITH, 0}, {"половиной", KIND_HALF_NOUN, 0},
+};
+
+uint64_t hashWord(std::string_view word)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (char c : word) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// Открытая адресация по номерам WORDS (+1, 0 — пусто); строится один раз при первом обращении.
+// Старшие биты хэша и длина лежат в ячейке: строка сравнивается только при их совпадении
+class WordTable
+{
+public:
+    WordTable()
+    {
+        memset(slots, 0, sizeof(slots));
+        for (size_t i = 0; i < sizeof(WORDS) / sizeof(WORDS[0]); ++i) {
+            std::string_view word = WORDS[i].word;
+            uint64_t hash = hashWord(word);
+            size_t slot = hash & (WORD_TABLE_SIZE - 1);
+            while (slots[slot].entry != 0) {
+                slot = (slot + 1) & (WORD_TABLE_SIZE - 1);
+            }
+            slots[slot].check = static_cast<uint32_t>(hash >> 32);
+            slots[slot].entry = static_cast<uint16_t>(i + 1);
+            slots[slot].length = static_cast<uint16_t>(word.size());
+        }
+    }
+
+    const WordEntry* find(std::string_view word) const
+    {
+        uint64_t hash = hashWord(word);
+        uint32_t check = static_cast<uint32_t>(hash >> 32);
+        for (size_t slot = hash & (WORD_TABLE_SIZE - 1); slots[slot].entry != 0;
+             slot = (slot + 1) & (WORD_TABLE_SIZE - 1)) {
+            const Slot& candidate = slots[slot];
+            if (candidate.check == check && candidate.length == word.size()) {
+                const WordEntry& entry = WORDS[candidate.entry - 1];
+                if (memcmp(entry.word, word.data(), word.size()) == 0) return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    struct Slot {
+        uint32_t check;
+        uint16_t entry;
+        uint16_t length;
+    };
+    Slot slots[WORD_TABLE_SIZE];
+};
+
+const WordTable& wordTable()
+{
+    static const WordTable table;
+    return table;
+}
+
+// Слово, начинающееся с позиции pos (одиночный пробел перед ним пропускается)
+struct Word {
+    std::string_view text;
+    size_t end = 0;                     // Позиция сразу за словом
+};
+
+Word wordAt(std::string_view text, size_t pos)
+{
+    Word word;
+    if (pos < text.size() && text[pos] == ' ') ++pos;
+    size_t end = text.find(' ', pos);
+    if (end == std::string_view::npos) end = text.size();
+    word.text = text.substr(pos, end - pos);
+    word.end = end;
+    return word;
+}
+
+bool parseDigits(std::string_view word, int64_t& value)
+{
+    if (word.empty() || word.size() > MAX_DIGITS) return false;
+    int64_t result = 0;
+    for (char c : word) {
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + (c - '0');
+    }
+    value = result;
+    return true;
+}
+
+// Единица времени; "полчаса", "полминуты" — слитно с "пол"
+const WordEntry* timeUnit(std::string_view word, double& amount, bool amountGiven)
+{
+    const WordEntry* entry = wordTable().find(word);
+    if (entry && entry->kind == KIND_TIME_UNIT) return entry;
+    static const std::string_view HALF_PREFIX = "пол";
+    if (!amountGiven && word.size() > HALF_PREFIX.size() && word.compare(0, HALF_PREFIX.size(), HALF_PREFIX) == 0) {
+        entry = wordTable().find(word.substr(HALF_PREFIX.size()));
+        if (entry && entry->kind == KIND_TIME_UNIT) {
+            amount = 0.5;
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+size_t NumeralParser::parseNumber(std::string_view text, int64_t& value)
+{
+    const WordTable& table = wordTable();
+    int64_t total = 0;
+    int64_t group = 0;                  // Сотни, десятки и единицы до следующего множителя
+    bool groupGiven = false;            // false — перед множителем ничего нет: "тысяча" = 1000
+    int lastRank = 4;                   // Следующее слово должно быть младше: 3 сотни, 2 десятки, 1 единицы
+    int64_t lastMultiplier = INT64_MAX;
+    size_t consumed = 0;
+    size_t pos = 0;
+
+    while (pos < text.size()) {
+        Word word = wordAt(text, pos);
+        if (word.text.empty()) break;
+
+        int64_t digits;
+        const WordEntry* entry = nullptr;
+        if (parseDigits(word.text, digits)) {
+            // "42", "5 тысяч": цифры — целая группа, дальше возможен только множитель
+            if (lastRank < 4) break;
+            group = digits;
+            groupGiven = true;
+            lastRank = 0;
+        } else if ((entry = table.find(word.text)) == nullptr) {
+            break;
+        } else if (entry->kind == KIND_ZERO) {
+            if (consumed != 0) break;
+            groupGiven = true;
+            lastRank = 0;
+        } else if (entry->kind == KIND_MULTIPLIER) {
+            // "ноль тысяч", "0 тысяч" — не число тысяч, множитель остаётся неразобранным
+            if (entry->value >= lastMultiplier || (groupGiven && group == 0)) break;
+            total += (groupGiven ? group : 1) * entry->value;
+            group = 0;
+            groupGiven = false;
+            lastRank = 4;
+            lastMultiplier = entry->value;
+        } else if (entry->kind >= KIND_UNITS && entry->kind <= KIND_HUNDREDS) {
+            int rank = entry->kind == KIND_UNITS ? 1 : entry->kind == KIND_HUNDREDS ? 3 : 2;
+            if (rank >= lastRank) break;
+            group += entry->value;
+            groupGiven = true;
+            // После "пятнадцать" единицы уже не добавить
+            lastRank = entry->kind == KIND_TEENS ? 1 : rank;
+        } else {
+            break;
+        }
+        pos = consumed = word.end;
+    }
+
+    if (consumed == 0) return 0;
+    value = total + group;
+    return consumed;
+}
+
+size_t NumeralParser::parseDuration(std::string_view text, int64_t& seconds)
+{
+    const WordTable& table = wordTable();
+    double total = 0.0;
+    size_t consumed = 0;
+    size_t pos = 0;
+
+    while (pos < text.size()) {
+        // Количество: число, "полтора", "пол" или ничего ("час", "минуту")
+        double amount = 1.0;
+        bool amountGiven = false;
+        int64_t number;
+        size_t length = parseNumber(text.substr(pos), number);
+        if (length > 0) {
+            amount = static_cast<double>(number);
+            amountGiven = true;
+            pos += length;
+        } else {
+            Word word = wordAt(text, pos);
+            const WordEntry* entry = table.find(word.text);
+            if (entry && (entry->kind == KIND_ONE_AND_HALF || entry->kind == KIND_HALF)) {
+                amount = entry->kind == KIND_ONE_AND_HALF ? 1.5 : 0.5;
+                amountGiven = true;
+                pos = word.end;
+            }
+        }
+
+        Word unitWord = wordAt(text, pos);
+        const WordEntry* unit = timeUnit(unitWord.text, amount, amountGiven);
+        if (!unit) break;
+        total += amount * unit->value;
+        pos = consumed = unitWord.end;
+
+        // "час с половиной"
+        Word with = wordAt(text, pos);
+        const WordEntry* withEntry = table.find(with.text);
+        if (withEntry && withEntry->kind == KIND_WITH) {
+            Word half = wordAt(text, with.end);
+            const WordEntry* halfEntry = table.find(half.text);
+            if (halfEntry && halfEntry->kind == KIND_HALF_NOUN) {
+                total += 0.5 * unit->value;
+                pos = consumed = half.end;
+            }
+        }
+
+        // "две минуты и десять секунд": связка съедается, только если за ней следующая часть
+        Word next = wordAt(text, pos);
+        const WordEntry* nextEntry = table.find(next.text);
+        if (nextEntry && nextEntry->kind == KIND_AND) {
+            pos = next.end;
+        }
+    }
+
+    // Число с множителем в днях ("миллион дней") уже не длительность: параметр отклоняется целиком
+    if (consumed == 0 || total > MAX_DURATION_SECONDS) return 0;
+    seconds = std::llround(total);
+    return consumed;
+}
+
+std::vector<std::string> NumeralParser::vocabulary()
+{
+    std::vector<std::string> words;
+    for (const auto& entry : WORDS) {
+        words.push_back(entry.word);
+    }
+    words.push_back("полчаса");
+    words.push_back("полминуты");
+    return words;
+}
@@ -0,0 +1,27 @@
+#ifndef NUMERALPARSER_H
+#define NUMERALPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Разбор русских числительных и длительностей в свёрнутом тексте (foldText: нижний регистр,
+// ё → е, слова через один пробел). Слова ищутся в статической хэш-таблице, разбор
+// идёт одним проходом по словам и не выделяет память.
+class NumeralParser
+{
+public:
+    // Число в начале text: "сто двадцать пять", "две тысячи сорок", "42".
+    // Возвращает длину разобранной части в байтах (0 — в начале нет числа)
+    static size_t parseNumber(std::string_view text, int64_t& value);
+    // Длительность в начале text в секундах: "пять минут", "полтора часа", "полчаса",
+    // "час тридцать минут", "две минуты и десять секунд", "час с половиной"
+    static size_t parseDuration(std::string_view text, int64_t& seconds);
+
+    // Все слова числительных и единиц времени (для грамматики распознавателя)
+    static std::vector<std::string> vocabulary();
+};
+
+#endif // NUMERALPARSER_H
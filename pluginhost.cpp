@@ -0,0 +1,373 @@
+#include "pluginhost.h"
+#include <QString>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+// Сколько потоков может оставаться занятыми модулями после таймаута; дальше замены не запускаются
+#define PLUGIN_MAX_STUCK 8
+// Сколько shutdown() ждёт вызовы, уже выполняющиеся в потоках пула
+#define PLUGIN_SHUTDOWN_WAIT_MS 2000
+
+using Clock = std::chrono::steady_clock;
+
+static double microsecondsBetween(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+struct PluginHost::Call {
+    PluginRequest request;
+    State *state = nullptr;
+    Clock::time_point queued;
+    Clock::time_point started;
+    Clock::time_point deadline = Clock::time_point::max();
+    std::atomic<bool> cancelled{false};
+    bool timedOut = false;              // Под mutex: поток вызова заменён, итог уже сообщён
+    bool reported = false;              // Под mutex: done вызван или вызывать его больше нельзя
+    std::vector<va_slot> abiSlots;      // Указывают в request.slot_values
+    va_call abi;
+};
+
+struct PluginHost::State {
+    mutable std::mutex mutex;
+    std::condition_variable work;       // Потоки пула: новые вызовы, остановка
+    std::condition_variable watch;      // Сторож: новые сроки, остановка
+    std::condition_variable idle;       // shutdown(): потоки пула и начатые обратные вызовы
+    std::deque<std::shared_ptr<Call>> queue;
+    std::vector<std::shared_ptr<Call>> running;
+    PluginOptions options;
+    PluginStats counters;
+    unsigned int workers = 0;           // Потоки пула, кроме занятых модулями после таймаута
+    unsigned int reporting = 0;         // Обратные вызовы, выполняющиеся прямо сейчас
+    bool stopping = false;
+    PluginHost *owner = nullptr;        // Для журнала; nullptr после shutdown()
+};
+
+CommandPlugin::~CommandPlugin()
+{
+    if (shutdown) shutdown();
+    if (handle) dlclose(handle);
+}
+
+PluginHost::PluginHost(QObject *parent)
+    : QObject(parent)
+    , state(std::make_shared<State>())
+{
+    state->owner = this;
+}
+
+PluginHost::~PluginHost()
+{
+    shutdown();
+}
+
+void PluginHost::configure(const PluginOptions& opts)
+{
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->options = opts;
+    state->options.threads = std::max(1u, state->options.threads);
+    state->options.defaultTimeoutMs = std::max(0, state->options.defaultTimeoutMs);
+    // Потоки запускаются к первому вызову; лишние завершаются сами
+    if (state->workers > 0) ensureThreads();
+    state->work.notify_all();
+}
+
+std::shared_ptr<CommandPlugin> PluginHost::load(const std::string& path, std::string& error)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        error = strerror(errno);
+        return nullptr;
+    }
+
+    auto it = loaded.find(path);
+    if (it != loaded.end()) {
+        const CommandPlugin& current = *it->second;
+        if (current.device == info.st_dev && current.inode == info.st_ino &&
+            current.modified.tv_sec == info.st_mtim.tv_sec && current.modified.tv_nsec == info.st_mtim.tv_nsec) {
+            return it->second;
+        }
+        // По тому же пути dlopen вернёт прежнюю копию, пока она загружена
+        if (it->second.use_count() > 1) {
+            emit logMessage(QString("Модуль %1 изменился, но ещё выполняется: новая версия загрузится при следующем изменении")
+                            .arg(QString::fromStdString(path)));
+            return it->second;
+        }
+        loaded.erase(it);
+    }
+
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        error = dlerror();
+        return nullptr;
+    }
+    auto init = reinterpret_cast<va_plugin_init_fn>(dlsym(handle, "va_plugin_init"));
+    auto keywords = reinterpret_cast<va_plugin_keywords_fn>(dlsym(handle, "va_plugin_keywords"));
+    auto execute = reinterpret_cast<va_plugin_execute_fn>(dlsym(handle, "va_plugin_execute"));
+    if (!init || !keywords || !execute) {
+        error = "нет функций va_plugin_init, va_plugin_keywords и va_plugin_execute";
+        dlclose(handle);
+        return nullptr;
+    }
+    int initResult = init(VA_PLUGIN_ABI_VERSION);
+    if (initResult != 0) {
+        error = "va_plugin_init вернула " + std::to_string(initResult) +
+                " (версия ABI " + std::to_string(VA_PLUGIN_ABI_VERSION) + ")";
+        dlclose(handle);
+        return nullptr;
+    }
+
+    std::shared_ptr<CommandPlugin> plugin(new CommandPlugin());
+    plugin->filePath = path;
+    plugin->handle = handle;
+    plugin->execute = execute;
+    plugin->shutdown = reinterpret_cast<va_plugin_shutdown_fn>(dlsym(handle, "va_plugin_shutdown"));
+    const char *header = keywords();
+    plugin->headerText = header ? header : "";
+    plugin->device = info.st_dev;
+    plugin->inode = info.st_ino;
+    plugin->modified = info.st_mtim;
+    loaded[path] = plugin;
+    return plugin;
+}
+
+void PluginHost::retainOnly(const std::vector<std::string>& paths)
+{
+    for (auto it = loaded.begin(); it != loaded.end();) {
+        if (std::find(paths.begin(), paths.end(), it->first) == paths.end()) {
+            it = loaded.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PluginHost::ensureThreads()
+{
+    // Поток, занятый модулем после таймаута, заменяется, но не больше PLUGIN_MAX_STUCK раз подряд
+    while (state->workers < state->options.threads && state->counters.stuckThreads < PLUGIN_MAX_STUCK) {
+        ++state->workers;
+        std::thread(&PluginHost::workerLoop, state).detach();
+    }
+    if (!watchdog.joinable()) {
+        watchdog = std::thread(&PluginHost::watchdogLoop, this);
+    }
+}
+
+bool PluginHost::submit(PluginRequest request)
+{
+    if (!request.plugin) return false;
+
+    auto call = std::make_shared<Call>();
+    call->request = std::move(request);
+    call->state = state.get();
+    call->abiSlots.reserve(call->request.slot_values.size());
+    for (const auto& slot : call->request.slot_values) {
+        call->abiSlots.push_back(va_slot{slot.name.c_str(), slot.value.c_str()});
+    }
+    call->abi.command = call->request.command.c_str();
+    call->abi.stream = call->request.stream.c_str();
+    call->abi.slot_values = call->abiSlots.data();
+    call->abi.slot_count = call->abiSlots.size();
+    call->abi.host = call.get();
+    call->abi.cancelled = &PluginHost::callCancelled;
+    call->abi.log = &PluginHost::callLog;
+    call->queued = Clock::now();
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->stopping) return false;
+    if (state->queue.size() >= state->options.maxQueued) {
+        ++state->counters.rejected;
+        return false;
+    }
+    ensureThreads();
+    state->queue.push_back(std::move(call));
+    ++state->counters.submitted;
+    state->work.notify_one();
+    return true;
+}
+
+void PluginHost::report(State& state, std::unique_lock<std::mutex>& lock, Call& call, bool succeeded)
+{
+    if (call.reported) return;
+    call.reported = true;
+    if (!call.request.done) return;
+    // Обратный вызов может поставить следующую команду — без блокировки
+    ++state.reporting;
+    lock.unlock();
+    call.request.done(succeeded);
+    lock.lock();
+    --state.reporting;
+    state.idle.notify_all();
+}
+
+void PluginHost::workerLoop(std::shared_ptr<State> state)
+{
+    std::unique_lock<std::mutex> lock(state->mutex);
+    for (;;) {
+        state->work.wait(lock, [&state]() {
+            return state->stopping || !state->queue.empty() || state->workers > state->options.threads;
+        });
+        if (state->stopping || state->workers > state->options.threads) {
+            --state->workers;
+            state->idle.notify_all();
+            return;
+        }
+
+        std::shared_ptr<Call> call = std::move(state->queue.front());
+        state->queue.pop_front();
+        call->started = Clock::now();
+        int timeoutMs = call->request.timeoutMs < 0 ? state->options.defaultTimeoutMs : call->request.timeoutMs;
+        if (timeoutMs > 0) {
+            call->deadline = call->started + std::chrono::milliseconds(timeoutMs);
+            state->watch.notify_one();
+        }
+        state->counters.queueUsMax = std::max(state->counters.queueUsMax, microsecondsBetween(call->queued, call->started));
+        state->running.push_back(call);
+        lock.unlock();
+
+        int result = call->request.plugin->execute(&call->abi);
+        double runUs = microsecondsBetween(call->started, Clock::now());
+
+        lock.lock();
+        state->running.erase(std::find(state->running.begin(), state->running.end(), call));
+        if (call->timedOut) {
+            // Вместо этого потока уже запущен другой; свободный поток возвращается в пул, лишний завершается
+            --state->counters.stuckThreads;
+            ++state->counters.lateReturns;
+            if (state->stopping || state->workers >= state->options.threads) {
+                lock.unlock();
+                return;
+            }
+            ++state->workers;
+            continue;
+        }
+        ++state->counters.executed;
+        ++(result == 0 ? state->counters.succeeded : state->counters.failed);
+        state->counters.runUsTotal += runUs;
+        state->counters.runUsMax = std::max(state->counters.runUsMax, runUs);
+        report(*state, lock, *call, result == 0);
+    }
+}
+
+void PluginHost::watchdogLoop()
+{
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->stopping) {
+        auto now = Clock::now();
+        auto next = Clock::time_point::max();
+        std::vector<std::shared_ptr<Call>> expired;
+        for (const auto& call : state->running) {
+            if (call->timedOut) continue;
+            if (call->deadline <= now) {
+                expired.push_back(call);
+            } else {
+                next = std::min(next, call->deadline);
+            }
+        }
+        if (expired.empty()) {
+            if (next == Clock::time_point::max()) {
+                state->watch.wait(lock);
+            } else {
+                state->watch.wait_until(lock, next);
+            }
+            continue;
+        }
+
+        // Код модуля не прервать: вызов считается неудачным, поток — потерянным до возврата из модуля
+        for (const auto& call : expired) {
+            call->timedOut = true;
+            call->cancelled = true;
+            ++state->counters.timedOut;
+            ++state->counters.stuckThreads;
+            --state->workers;
+            emit logMessage(QString("Модуль %1 не уложился в %2 мс: вызов считается неудачным, поток пула заменён")
+                            .arg(QString::fromStdString(call->request.command))
+                            .arg(static_cast<qint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 call->deadline - call->started).count())));
+        }
+        if (state->counters.stuckThreads >= PLUGIN_MAX_STUCK) {
+            emit logMessage(QString("Занято зависшими модулями потоков: %1, новые потоки не запускаются")
+                            .arg(state->counters.stuckThreads));
+        }
+        ensureThreads();
+        state->work.notify_all();
+        for (const auto& call : expired) {
+            report(*state, lock, *call, false);
+        }
+    }
+}
+
+int PluginHost::callCancelled(const va_call *abi)
+{
+    return static_cast<const Call*>(abi->host)->cancelled.load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+void PluginHost::callLog(const va_call *abi, const char *message)
+{
+    if (!message) return;
+    const Call *call = static_cast<const Call*>(abi->host);
+    std::lock_guard<std::mutex> lock(call->state->mutex);
+    if (!call->state->owner) return;
+    emit call->state->owner->logMessage(QString("%1: %2")
+                                        .arg(QString::fromStdString(call->request.command), QString::fromUtf8(message)));
+}
+
+void PluginHost::cancelAll(bool cancelRunning)
+{
+    std::unique_lock<std::mutex> lock(state->mutex);
+    std::deque<std::shared_ptr<Call>> cancelled;
+    cancelled.swap(state->queue);
+    if (cancelRunning) {
+        for (const auto& call : state->running) {
+            call->cancelled = true;
+        }
+    }
+    // Не начатые вызовы тоже получают итог: цепочки зависимых команд не должны ждать вечно
+    for (const auto& call : cancelled) {
+        report(*state, lock, *call, false);
+    }
+    if (!cancelled.empty()) {
+        emit logMessage(QString("Отменено вызовов модулей в очереди: %1").arg(static_cast<qint64>(cancelled.size())));
+    }
+}
+
+void PluginHost::shutdown()
+{
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (!state->stopping) {
+            state->stopping = true;
+            std::deque<std::shared_ptr<Call>> cancelled;
+            cancelled.swap(state->queue);
+            for (const auto& call : cancelled) {
+                report(*state, lock, *call, false);
+            }
+            // Итоги работающих вызовов больше никому не нужны
+            for (const auto& call : state->running) {
+                call->cancelled = true;
+                call->reported = true;
+            }
+            state->work.notify_all();
+            state->watch.notify_all();
+            // Зависшие модули не ждём: их потоки отсоединены и держат только общее состояние
+            state->idle.wait_for(lock, std::chrono::milliseconds(PLUGIN_SHUTDOWN_WAIT_MS),
+                                 [this]() { return state->workers == 0; });
+            state->idle.wait(lock, [this]() { return state->reporting == 0; });
+            state->owner = nullptr;
+        }
+    }
+    if (watchdog.joinable()) {
+        watchdog.join();
+    }
+}
+
+PluginStats PluginHost::stats() const
+{
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->counters;
+}
@@ -0,0 +1,124 @@
+#ifndef PLUGINHOST_H
+#define PLUGINHOST_H
+
+#include <QObject>
+#include "slotpattern.h"
+#include "voiceassistant_plugin.h"
+#include <sys/types.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Параметры пула модулей
+struct PluginOptions {
+    unsigned int threads = 2;           // Потоков, выполняющих модули
+    size_t maxQueued = 32;              // Ожидающих вызовов; сверх — отказ
+    int defaultTimeoutMs = 5000;        // Для модулей без # TIMEOUT (0 — без ограничения)
+};
+
+// Загруженный модуль; выгружается (dlclose), когда на него не ссылаются ни команды, ни вызовы
+class CommandPlugin
+{
+public:
+    ~CommandPlugin();
+
+    const std::string& path() const { return filePath; }
+    // Заголовок из va_plugin_keywords: # WORDS, # PRIORITY, # TIMEOUT
+    const std::string& header() const { return headerText; }
+
+private:
+    friend class PluginHost;
+    CommandPlugin() = default;
+
+    std::string filePath;
+    std::string headerText;
+    void *handle = nullptr;
+    va_plugin_execute_fn execute = nullptr;
+    va_plugin_shutdown_fn shutdown = nullptr;
+    dev_t device = 0;                   // Файл, из которого загружен модуль: изменившийся загружается заново
+    ino_t inode = 0;
+    struct timespec modified = {0, 0};
+};
+
+// Вызов модуля
+struct PluginRequest {
+    std::shared_ptr<CommandPlugin> plugin;
+    std::string command;
+    std::string stream;
+    std::vector<SlotValue> slot_values;
+    int timeoutMs = -1;                 // -1 — PluginOptions::defaultTimeoutMs, 0 — без ограничения
+    // Вызывается один раз: в потоке пула, сторожа (таймаут) или отменяющем потоке
+    std::function<void(bool)> done;
+};
+
+// Счётчики (снимок)
+struct PluginStats {
+    uint64_t submitted = 0;
+    uint64_t rejected = 0;              // Очередь была полна
+    uint64_t executed = 0;              // Вернули управление вовремя
+    uint64_t succeeded = 0;
+    uint64_t failed = 0;
+    uint64_t timedOut = 0;
+    uint64_t lateReturns = 0;           // Вернули управление после таймаута
+    unsigned int stuckThreads = 0;      // Потоки, всё ещё занятые модулями после таймаута
+    double runUsTotal = 0.0;            // Только вернувшиеся вовремя
+    double runUsMax = 0.0;
+    double queueUsMax = 0.0;
+};
+
+// Выполнение команд-модулей в процессе ассистента. Вызовы ставятся в очередь и выполняются
+// пулом потоков; сторож следит за временем вызовов. Прервать код модуля нельзя, поэтому по
+// таймауту вызов считается неудачным (его done вызывается сразу, модуль видит cancelled),
+// а занятый поток заменяется новым. Модуль не выгружается, пока его вызов не вернул управление.
+class PluginHost : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PluginHost(QObject *parent = nullptr);
+    ~PluginHost();
+
+    void configure(const PluginOptions& options);
+    // Загружает модуль; неизменившийся файл повторно не загружается. nullptr — ошибка в error
+    std::shared_ptr<CommandPlugin> load(const std::string& path, std::string& error);
+    // Забывает модули, файлов которых больше нет среди paths
+    void retainOnly(const std::vector<std::string>& paths);
+
+    // false — очередь полна или пул остановлен; done тогда не вызывается
+    bool submit(PluginRequest request);
+    // Отменяет ожидающие вызовы (done(false)); cancelRunning — выставляет cancelled работающим
+    void cancelAll(bool cancelRunning);
+    // Перестаёт принимать вызовы и ждёт обратные вызовы, уже начатые в потоках пула.
+    // После возврата обратных вызовов больше не будет
+    void shutdown();
+
+    PluginStats stats() const;
+
+signals:
+    void logMessage(const QString& message);
+
+private:
+    struct Call;
+    struct State;
+
+    static void workerLoop(std::shared_ptr<State> state);
+    static void report(State& state, std::unique_lock<std::mutex>& lock, Call& call, bool succeeded);
+    static int callCancelled(const va_call *call);
+    static void callLog(const va_call *call, const char *message);
+    void ensureThreads();
+    void watchdogLoop();
+
+    std::shared_ptr<State> state;       // Общее с потоками пула: зависший поток может пережить хозяина
+    std::map<std::string, std::shared_ptr<CommandPlugin>> loaded;   // Только из потока, загружающего команды
+    std::thread watchdog;
+};
+
+#endif // PLUGINHOST_H
@@ -0,0 +1,26 @@
+// Пример команды-модуля: говорит в журнал, который час. Собирается CMake в commands/clock.so
+#include "voiceassistant_plugin.h"
+#include <time.h>
+
+int va_plugin_init(int abi_version)
+{
+    return abi_version == VA_PLUGIN_ABI_VERSION ? 0 : -1;
+}
+
+const char *va_plugin_keywords(void)
+{
+    return "# WORDS : который час, сколько времени\n"
+           "# TIMEOUT : 1\n";
+}
+
+int va_plugin_execute(const va_call *call)
+{
+    time_t now = time(NULL);
+    struct tm local;
+    if (!localtime_r(&now, &local)) return 1;
+
+    char text[64];
+    strftime(text, sizeof(text), "Сейчас %H:%M", &local);
+    call->log(call, text);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef PREROLLBUFFER_H
+#define PREROLLBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// История последних отсчётов фиксированной длины.
+// Пока шлюз закрыт, сюда пишется отброшенный звук; при открытии он проигрывается
+// в распознаватель, чтобы не терять начало фразы. Память выделяется только в configure().
+class PreRollBuffer
+{
+public:
+    void configure(size_t capacitySamples)
+    {
+        storage.assign(capacitySamples, 0);
+        clear();
+    }
+
+    void clear()
+    {
+        head = 0;
+        length = 0;
+    }
+
+    size_t size() const { return length; }
+    size_t capacity() const { return storage.size(); }
+
+    // Дописывает отсчёты, вытесняя самые старые
+    void append(const short* data, size_t count)
+    {
+        const size_t cap = storage.size();
+        if (cap == 0) return;
+        if (count >= cap) {
+            data += count - cap;
+            count = cap;
+        }
+
+        size_t tail = (head + length) % cap;
+        size_t first = std::min(count, cap - tail);
+        std::copy(data, data + first, storage.begin() + static_cast<std::ptrdiff_t>(tail));
+        std::copy(data + first, data + count, storage.begin());
+
+        length += count;
+        if (length > cap) {
+            head = (head + length - cap) % cap;
+            length = cap;
+        }
+    }
+
+    // Вызывает f(const short*, size_t) для одного или двух непрерывных участков, от старых к новым
+    template <typename F>
+    void forEachSpan(F&& f) const
+    {
+        if (length == 0) return;
+        const size_t cap = storage.size();
+        size_t first = std::min(length, cap - head);
+        f(storage.data() + head, first);
+        if (length > first) {
+            f(storage.data(), length - first);
+        }
+    }
+
+private:
+    std::vector<short> storage;
+    size_t head = 0;
+    size_t length = 0;
+};
+
+#endif // PREROLLBUFFER_H
@@ -0,0 +1,473 @@
+#include "processexecutor.h"
+#include <QString>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+extern char **environ;
+
+// Без pidfd (ядро старше 5.3) завершение процессов проверяется с этим интервалом
+#define FALLBACK_POLL_MS 50
+// Новые тёплые оболочки запускаются с задержкой: старт bash не должен отнимать процессор у только что запущенного скрипта
+#define SHELL_REPLENISH_DELAY_MS 20
+// Повтор, если новую оболочку запустить не удалось
+#define SHELL_RETRY_MS 1000
+
+using Clock = std::chrono::steady_clock;
+
+// Дескриптор, который становится читаемым при завершении процесса; -1 — не поддерживается
+static int openPidFd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+static double millisecondsBetween(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+ProcessExecutor::ProcessExecutor(QObject *parent)
+    : QObject(parent)
+    , nextId(1)
+    , stopping(false)
+    , wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+}
+
+ProcessExecutor::~ProcessExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    // Приложение закрывается — ждать SIGTERM некогда
+    cancelAll(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = Clock::now();
+        for (auto& job : running) {
+            job.killedOnStop = true;
+            signalGroup(job, SIGKILL, now);
+        }
+    }
+    wake();
+    if (supervisor.joinable()) {
+        supervisor.join();
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+}
+
+void ProcessExecutor::configure(const ExecutorOptions& opts)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    options = opts;
+    options.maxRunning = std::max(1u, options.maxRunning);
+    options.killGraceMs = std::max(0, options.killGraceMs);
+    // Тёплые оболочки поднимаются сразу, а не к первой команде
+    if (options.warmShells > 0 && wakeFd >= 0) {
+        ensureThread();
+    }
+    // Освободившиеся места занимаются из очереди
+    wake();
+}
+
+void ProcessExecutor::ensureThread()
+{
+    if (supervisor.joinable()) return;
+    supervisor = std::thread(&ProcessExecutor::supervisorLoop, this);
+}
+
+void ProcessExecutor::wake()
+{
+    if (wakeFd < 0) return;
+    uint64_t one = 1;
+    (void)write(wakeFd, &one, sizeof(one));
+}
+
+uint64_t ProcessExecutor::submit(ProcessRequest request)
+{
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return 0;
+        if (queue.size() >= options.maxQueued) {
+            ++counters.rejected;
+            return 0;
+        }
+        if (wakeFd < 0) {
+            emit logMessage("Исполнитель скриптов недоступен: не удалось создать eventfd");
+            return 0;
+        }
+        ensureThread();
+        Job job;
+        job.id = id = nextId++;
+        job.request = std::move(request);
+        job.queued = Clock::now();
+        queue.push_back(std::move(job));
+        ++counters.submitted;
+        counters.peakQueued = std::max(counters.peakQueued, queue.size());
+    }
+    wake();
+    return id;
+}
+
+void ProcessExecutor::cancelAll(bool killRunning)
+{
+    std::deque<Job> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled.swap(queue);
+        if (killRunning) {
+            auto now = Clock::now();
+            for (auto& job : running) {
+                if (job.terminating) continue;
+                job.killedOnStop = true;
+                signalGroup(job, SIGTERM, now);
+            }
+        }
+    }
+    if (killRunning) wake();
+
+    // Не запущенные запросы тоже получают итог: цепочки зависимых команд не должны ждать вечно
+    for (auto& job : cancelled) {
+        ProcessResult result;
+        result.id = job.id;
+        result.label = job.request.label;
+        result.queueMs = millisecondsBetween(job.queued, Clock::now());
+        if (job.request.done) job.request.done(result);
+    }
+    if (!cancelled.empty()) {
+        emit logMessage(QString("Отменено скриптов в очереди: %1").arg(static_cast<qint64>(cancelled.size())));
+    }
+}
+
+ExecutorStats ProcessExecutor::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+unsigned int ProcessExecutor::runningCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<unsigned int>(running.size());
+}
+
+void ProcessExecutor::signalGroup(Job& job, int signal, Clock::time_point now)
+{
+    if (job.pid <= 0) return;
+    // Группа создаётся при запуске: вместе со скриптом завершаются и его дочерние процессы
+    if (kill(-job.pid, signal) != 0) {
+        kill(job.pid, signal);
+    }
+    if (signal == SIGKILL) {
+        job.deadline = Clock::time_point::max();
+    } else {
+        job.terminating = true;
+        job.deadline = now + std::chrono::milliseconds(options.killGraceMs);
+    }
+}
+
+bool ProcessExecutor::spawn(Job& job)
+{
+    const ProcessRequest& request = job.request;
+
+    // Скрипт без права на выполнение запускается через /bin/sh
+    std::vector<char*> argv;
+    const bool direct = access(request.path.c_str(), X_OK) == 0;
+    if (!direct) {
+        argv.push_back(const_cast<char*>("/bin/sh"));
+    }
+    argv.push_back(const_cast<char*>(request.path.c_str()));
+    for (const auto& argument : request.arguments) {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    // Окружение приложения; переменные запроса заменяют одноимённые
+    std::vector<char*> envp;
+    for (char **entry = environ; entry && *entry; ++entry) {
+        const char *equals = std::strchr(*entry, '=');
+        size_t nameLength = equals ? static_cast<size_t>(equals - *entry) : std::strlen(*entry);
+        bool overridden = std::any_of(request.environment.begin(), request.environment.end(),
+                                      [&](const std::string& variable) {
+            return variable.size() > nameLength && variable[nameLength] == '=' &&
+                   variable.compare(0, nameLength, *entry, nameLength) == 0;
+        });
+        if (!overridden) envp.push_back(*entry);
+    }
+    for (const auto& variable : request.environment) {
+        envp.push_back(const_cast<char*>(variable.c_str()));
+    }
+    envp.push_back(nullptr);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attr, 0);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    // Скрипт не наследует обработчики и игнорирование сигналов приложения
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    for (int signal : {SIGPIPE, SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGCHLD, SIGUSR1, SIGUSR2}) {
+        sigaddset(&defaults, signal);
+    }
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    auto before = Clock::now();
+    pid_t pid = -1;
+    int err = posix_spawn(&pid, argv[0], nullptr, &attr, argv.data(), envp.data());
+    auto after = Clock::now();
+    posix_spawnattr_destroy(&attr);
+
+    job.spawnUs = std::chrono::duration<double, std::micro>(after - before).count();
+    if (err != 0) {
+        emit logMessage(QString("Не удалось запустить скрипт %1: %2")
+                        .arg(QString::fromStdString(request.label), QString(strerror(err))));
+        return false;
+    }
+
+    job.launched = true;
+    job.pid = pid;
+    job.pidfd = openPidFd(pid);
+    job.started = after;
+    return true;
+}
+
+bool ProcessExecutor::spawnWarm(Job& job)
+{
+    // Оболочка становится процессом скрипта; здесь только запись запроса в её канал
+    auto before = Clock::now();
+    pid_t pid = shells.run(job.request.path, job.request.arguments, job.request.environment);
+    auto after = Clock::now();
+    if (pid < 0) return false;
+
+    job.spawnUs = std::chrono::duration<double, std::micro>(after - before).count();
+    job.launched = true;
+    job.pid = pid;
+    job.pidfd = openPidFd(pid);
+    job.started = after;
+    return true;
+}
+
+void ProcessExecutor::setDeadline(Job& job)
+{
+    int timeoutMs = job.request.timeoutMs < 0 ? options.defaultTimeoutMs : job.request.timeoutMs;
+    job.deadline = timeoutMs > 0 ? job.started + std::chrono::milliseconds(timeoutMs) : Clock::time_point::max();
+}
+
+void ProcessExecutor::finish(Job& job, int exitCode, int signal)
+{
+    ProcessResult result;
+    result.id = job.id;
+    result.label = job.request.label;
+    result.spawned = job.launched;
+    result.timedOut = job.timedOut;
+    result.queueMs = millisecondsBetween(job.queued, job.launched ? job.started : Clock::now());
+    result.spawnUs = job.spawnUs;
+    if (result.spawned) {
+        result.runMs = millisecondsBetween(job.started, Clock::now());
+        result.exitCode = exitCode;
+        result.signal = signal;
+        result.statusLost = job.statusLost;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!result.spawned) {
+            ++counters.spawnFailed;
+        } else if (job.killedOnStop) {
+            ++counters.killedOnStop;
+        } else if (result.timedOut) {
+            ++counters.timedOut;
+        } else if (result.succeeded()) {
+            ++counters.succeeded;
+        } else {
+            ++counters.failed;
+        }
+        if (result.spawned) {
+            counters.spawnUsTotal += result.spawnUs;
+            counters.spawnUsMax = std::max(counters.spawnUsMax, result.spawnUs);
+        }
+        counters.queueMsMax = std::max(counters.queueMsMax, result.queueMs);
+    }
+
+    QString label = QString::fromStdString(result.label);
+    if (result.spawned) {
+        if (job.killedOnStop) {
+            emit logMessage(QString("Скрипт %1 остановлен вместе с ассистентом").arg(label));
+        } else if (result.timedOut) {
+            emit logMessage(QString("Скрипт %1 остановлен по таймауту через %2 мс")
+                            .arg(label).arg(result.runMs, 0, 'f', 0));
+        } else if (result.succeeded()) {
+            emit logMessage(QString("Скрипт %1 выполнен успешно за %2 мс").arg(label).arg(result.runMs, 0, 'f', 1));
+        } else if (result.statusLost) {
+            emit logMessage(QString("Скрипт %1 завершён, код завершения неизвестен (процесс собран не исполнителем)")
+                            .arg(label));
+        } else if (result.signal != 0) {
+            emit logMessage(QString("Скрипт %1 завершён сигналом %2").arg(label).arg(result.signal));
+        } else {
+            emit logMessage(QString("Ошибка выполнения скрипта %1: код %2").arg(label).arg(result.exitCode));
+        }
+        emit processFinished(result.id, label, result.exitCode, result.timedOut, result.runMs);
+    }
+    if (job.request.done) job.request.done(result);
+}
+
+void ProcessExecutor::supervisorLoop()
+{
+    std::vector<pollfd> fds;
+    std::vector<Job> finished;
+    size_t appliedShells = 0;
+    Clock::time_point replenishAt = Clock::time_point::max();
+
+    for (;;) {
+        // Число тёплых оболочек меняется через configure()
+        size_t wantedShells;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wantedShells = stopping ? 0 : options.warmShells;
+        }
+        if (wantedShells != appliedShells) {
+            std::string error;
+            if (!shells.start(wantedShells, error)) {
+                emit logMessage(QString("Тёплые оболочки не запущены: %1").arg(QString::fromStdString(error)));
+            } else if (wantedShells > 0) {
+                emit logMessage(QString("Тёплых оболочек для скриптов: %1").arg(static_cast<qint64>(wantedShells)));
+            }
+            appliedShells = wantedShells;
+        }
+
+        // Запуск из очереди: posix_spawn идёт без блокировки, submit() в это время не ждёт
+        for (;;) {
+            Job job;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping || queue.empty() || running.size() >= options.maxRunning) break;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            bool warm = spawnWarm(job);
+            if (!warm && !spawn(job)) {
+                finish(job, -1, 0);
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            setDeadline(job);
+            if (stopping) {
+                job.killedOnStop = true;
+                signalGroup(job, SIGKILL, Clock::now());
+            }
+            running.push_back(std::move(job));
+            ++counters.spawned;
+            if (warm) ++counters.warmLaunches;
+            counters.peakRunning = std::max(counters.peakRunning, static_cast<unsigned int>(running.size()));
+        }
+        if (replenishAt == Clock::time_point::max() && shells.hasVacancy()) {
+            replenishAt = Clock::now() + std::chrono::milliseconds(SHELL_REPLENISH_DELAY_MS);
+        }
+
+        // Ожидание: завершение любого процесса, новый запрос или ближайший срок
+        fds.clear();
+        fds.push_back(pollfd{wakeFd, POLLIN, 0});
+        int timeoutMs = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping && running.empty()) break;
+            auto now = Clock::now();
+            bool fallback = false;
+            if (replenishAt != Clock::time_point::max()) {
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(replenishAt - now).count();
+                timeoutMs = static_cast<int>(std::max<decltype(left)>(0, left));
+            }
+            for (const auto& job : running) {
+                if (job.pidfd >= 0) {
+                    fds.push_back(pollfd{job.pidfd, POLLIN, 0});
+                } else {
+                    fallback = true;
+                }
+                if (job.deadline != Clock::time_point::max()) {
+                    auto left = std::chrono::ceil<std::chrono::milliseconds>(job.deadline - now).count();
+                    int wait = static_cast<int>(std::max<decltype(left)>(0, left));
+                    timeoutMs = timeoutMs < 0 ? wait : std::min(timeoutMs, wait);
+                }
+            }
+            if (fallback) {
+                timeoutMs = timeoutMs < 0 ? FALLBACK_POLL_MS : std::min(timeoutMs, FALLBACK_POLL_MS);
+            }
+        }
+        int ready = poll(fds.data(), fds.size(), timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            emit logMessage(QString("Ошибка ожидания скриптов: %1").arg(strerror(errno)));
+            std::this_thread::sleep_for(std::chrono::milliseconds(FALLBACK_POLL_MS));
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            uint64_t value;
+            (void)read(wakeFd, &value, sizeof(value));
+        }
+        // Место ушедших в скрипты и упавших в простое оболочек занимают новые
+        if (Clock::now() >= replenishAt) {
+            replenishAt = shells.replenish() ? Clock::time_point::max()
+                                             : Clock::now() + std::chrono::milliseconds(SHELL_RETRY_MS);
+        }
+
+        // Сбор завершённых и снятие просроченных
+        finished.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.shellRestarts = shells.restarts();
+            auto now = Clock::now();
+            for (size_t i = 0; i < running.size();) {
+                Job& job = running[i];
+                int status = 0;
+                pid_t reaped = waitpid(job.pid, &status, WNOHANG);
+                if (reaped == job.pid || (reaped < 0 && errno == ECHILD)) {
+                    if (job.pidfd >= 0) close(job.pidfd);
+                    if (reaped == job.pid) {
+                        job.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                        job.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+                    } else {
+                        // ECHILD: процесс уже собран (SIGCHLD в SIG_IGN, чужой waitpid) — статус потерян,
+                        // успехом это не считается
+                        job.exitCode = -1;
+                        job.signal = 0;
+                        job.statusLost = true;
+                    }
+                    finished.push_back(std::move(job));
+                    running.erase(running.begin() + static_cast<std::ptrdiff_t>(i));
+                    continue;
+                }
+                if (now >= job.deadline) {
+                    if (!job.terminating) {
+                        job.timedOut = !job.killedOnStop;
+                        signalGroup(job, SIGTERM, now);
+                    } else {
+                        signalGroup(job, SIGKILL, now);
+                    }
+                }
+                ++i;
+            }
+        }
+        // Обратные вызовы — без блокировки: они могут сразу поставить следующие команды
+        for (auto& job : finished) {
+            finish(job, job.exitCode, job.signal);
+        }
+    }
+    shells.stop();
+}
@@ -0,0 +1,139 @@
+#ifndef PROCESSEXECUTOR_H
+#define PROCESSEXECUTOR_H
+
+#include <QObject>
+#include "shellpool.h"
+#include <sys/types.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Параметры исполнителя
+struct ExecutorOptions {
+    unsigned int maxRunning = 4;        // Одновременно работающих процессов
+    size_t maxQueued = 32;              // Ожидающих запуска; сверх — отказ
+    int defaultTimeoutMs = 0;           // Для запросов без своего таймаута (0 — без ограничения)
+    int killGraceMs = 2000;             // Между SIGTERM и SIGKILL
+    size_t warmShells = 0;              // Заранее запущенных bash для скриптов (0 — только posix_spawn)
+};
+
+// Итог процесса
+struct ProcessResult {
+    uint64_t id = 0;
+    std::string label;
+    bool spawned = false;               // false — не запущен (ошибка posix_spawn, отмена при остановке)
+    int exitCode = -1;                  // -1 — завершён сигналом или код не получен
+    int signal = 0;
+    bool statusLost = false;            // Код завершения не получен (процесс собран не нами): неудача
+    bool timedOut = false;
+    double queueMs = 0.0;               // От постановки в очередь до запуска
+    double spawnUs = 0.0;               // Длительность posix_spawn или передачи пути тёплой оболочке
+    double runMs = 0.0;
+
+    bool succeeded() const { return spawned && exitCode == 0 && !timedOut; }
+};
+
+// Запрос на запуск
+struct ProcessRequest {
+    std::string path;                   // Исполняемый файл; без права на выполнение — через /bin/sh
+    std::vector<std::string> arguments;
+    std::vector<std::string> environment;   // NAME=value поверх окружения приложения
+    std::string label;                  // Имя в журнале
+    int timeoutMs = -1;                 // -1 — ExecutorOptions::defaultTimeoutMs, 0 — без ограничения
+    // Вызывается в потоке исполнителя после завершения процесса
+    std::function<void(const ProcessResult&)> done;
+};
+
+// Счётчики (снимок)
+struct ExecutorStats {
+    uint64_t submitted = 0;
+    uint64_t rejected = 0;              // Очередь была полна
+    uint64_t spawned = 0;
+    uint64_t warmLaunches = 0;          // Из них через тёплые оболочки
+    uint64_t shellRestarts = 0;
+    uint64_t spawnFailed = 0;
+    uint64_t succeeded = 0;
+    uint64_t failed = 0;                // Ненулевой код или сигнал
+    uint64_t timedOut = 0;
+    uint64_t killedOnStop = 0;
+    double spawnUsTotal = 0.0;          // Только успешные запуски
+    double spawnUsMax = 0.0;
+    double queueMsMax = 0.0;
+    unsigned int peakRunning = 0;
+    size_t peakQueued = 0;
+};
+
+// Асинхронный запуск скриптов команд вместо system() в потоке распознавания.
+// Процессы создаются posix_spawn в собственной группе; не больше maxRunning одновременно,
+// остальные ждут в очереди. Поток исполнителя ждёт завершения через pidfd (poll), снимает
+// процессы по таймауту (SIGTERM группе, затем SIGKILL) и сообщает итог обратным вызовом
+// и сигналом processFinished. Вызывающий поток блокируется только на постановке в очередь.
+// С warmShells скрипты по возможности передаются заранее запущенным оболочкам (ShellPool).
+class ProcessExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProcessExecutor(QObject *parent = nullptr);
+    ~ProcessExecutor();
+
+    void configure(const ExecutorOptions& options);
+    // Номер запроса или 0, если очередь полна
+    uint64_t submit(ProcessRequest request);
+    // Отменяет ожидающие запросы; killRunning — завершает и работающие процессы (с их группами)
+    void cancelAll(bool killRunning);
+
+    ExecutorStats stats() const;
+    unsigned int runningCount() const;
+
+signals:
+    void logMessage(const QString& message);
+    // Из потока исполнителя
+    void processFinished(quint64 id, const QString& label, int exitCode, bool timedOut, double runMs);
+
+private:
+    struct Job {
+        uint64_t id = 0;
+        ProcessRequest request;
+        std::chrono::steady_clock::time_point queued;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point deadline;     // time_point::max() — без ограничения
+        bool launched = false;
+        pid_t pid = -1;
+        int pidfd = -1;
+        int exitCode = -1;              // Итог, пока задание ждёт обратного вызова
+        int signal = 0;
+        bool statusLost = false;
+        bool terminating = false;       // SIGTERM отправлен, ждём до deadline перед SIGKILL
+        bool timedOut = false;
+        bool killedOnStop = false;
+        double spawnUs = 0.0;
+    };
+
+    void ensureThread();
+    void supervisorLoop();
+    bool spawn(Job& job);
+    bool spawnWarm(Job& job);
+    void setDeadline(Job& job);
+    void signalGroup(Job& job, int signal, std::chrono::steady_clock::time_point now);
+    void finish(Job& job, int exitCode, int signal);
+    void wake();
+
+    ExecutorOptions options;
+    mutable std::mutex mutex;
+    std::deque<Job> queue;
+    std::vector<Job> running;
+    ExecutorStats counters;
+    ShellPool shells;                   // Только из потока исполнителя
+    uint64_t nextId;
+    bool stopping;
+    const int wakeFd;                   // eventfd: новые запросы, отмена и смена настроек
+    std::thread supervisor;
+};
+
+#endif // PROCESSEXECUTOR_H
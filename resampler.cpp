@@ -0,0 +1,295 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RESAMPLER_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RESAMPLER_NEON 1
+#endif
+
+namespace {
+
+// Число коэффициентов на фазу (кратно 8 для векторных ядер)
+const size_t TAPS_PER_PHASE = 32;
+// Частота среза относительно меньшей из частот Найквиста
+const double CUTOFF = 0.92;
+
+float dotScalar(const float* a, const float* b, size_t n)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if defined(RESAMPLER_X86)
+__attribute__((target("sse2")))
+float dotSse(const float* a, const float* b, size_t n)
+{
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    __m128 shuf = _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1));
+    acc = _mm_add_ps(acc, shuf);
+    shuf = _mm_movehl_ps(shuf, acc);
+    acc = _mm_add_ss(acc, shuf);
+    float sum = _mm_cvtss_f32(acc);
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+float dotAvx2(const float* a, const float* b, size_t n)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 lo = _mm256_castps256_ps128(acc);
+    __m128 hi = _mm256_extractf128_ps(acc, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1));
+    lo = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, lo);
+    lo = _mm_add_ss(lo, shuf);
+    float sum = _mm_cvtss_f32(lo);
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+#endif
+
+#if defined(RESAMPLER_NEON)
+float dotNeon(const float* a, const float* b, size_t n)
+{
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    float sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+#endif
+
+double sinc(double x)
+{
+    if (std::fabs(x) < 1e-9) return 1.0;
+    return std::sin(M_PI * x) / (M_PI * x);
+}
+
+// Окно Блэкмана на отрезке [-1, 1]
+double blackman(double x)
+{
+    if (std::fabs(x) >= 1.0) return 0.0;
+    double t = (x + 1.0) * 0.5;
+    return 0.42 - 0.5 * std::cos(2.0 * M_PI * t) + 0.08 * std::cos(4.0 * M_PI * t);
+}
+
+} // namespace
+
+Resampler::Resampler()
+    : inRate(16000)
+    , outRate(16000)
+    , channels(1)
+    , passthrough(true)
+    , up(1)
+    , down(1)
+    , taps(TAPS_PER_PHASE)
+    , historyLength(0)
+    , position(0)
+    , phase(0)
+    , dot(dotScalar)
+    , kernelLabel("scalar")
+{
+#if defined(RESAMPLER_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dot = dotAvx2;
+        kernelLabel = "avx2";
+    } else {
+        dot = dotSse;
+        kernelLabel = "sse";
+    }
+#elif defined(RESAMPLER_NEON)
+    dot = dotNeon;
+    kernelLabel = "neon";
+#endif
+}
+
+bool Resampler::selectKernel(const char* name)
+{
+    if (strcmp(name, "scalar") == 0) {
+        dot = dotScalar;
+        kernelLabel = "scalar";
+        return true;
+    }
+#if defined(RESAMPLER_X86)
+    if (strcmp(name, "sse") == 0) {
+        dot = dotSse;
+        kernelLabel = "sse";
+        return true;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        dot = dotAvx2;
+        kernelLabel = "avx2";
+        return true;
+    }
+#elif defined(RESAMPLER_NEON)
+    if (strcmp(name, "neon") == 0) {
+        dot = dotNeon;
+        kernelLabel = "neon";
+        return true;
+    }
+#endif
+    return false;
+}
+
+void Resampler::configure(unsigned int inputRate, unsigned int inputChannels, unsigned int outputRate, size_t maxInputFrames)
+{
+    inRate = inputRate;
+    channels = std::max(1u, inputChannels);
+    outRate = outputRate;
+    passthrough = (inRate == outRate && channels == 1);
+
+    unsigned int g = std::gcd(inRate, outRate);
+    up = outRate / g;
+    down = inRate / g;
+
+    if (!passthrough) {
+        buildFilter();
+    }
+
+    // История: окно фильтра плюс самый большой входной блок
+    history.assign(taps + maxInputFrames, 0.0f);
+    reset();
+}
+
+void Resampler::reset()
+{
+    // Начальная задержка в полокна заполнена тишиной
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyLength = taps / 2;
+    position = 0;
+    phase = 0;
+}
+
+void Resampler::buildFilter()
+{
+    // При понижении частоты срез по выходному Найквисту, при повышении — по входному
+    const double cutoff = CUTOFF * std::min(1.0, static_cast<double>(up) / down);
+    const double half = static_cast<double>(taps) / 2.0;
+
+    coefficients.assign(static_cast<size_t>(up) * taps, 0.0f);
+    for (unsigned int p = 0; p < up; ++p) {
+        float* c = coefficients.data() + static_cast<size_t>(p) * taps;
+        const double frac = static_cast<double>(p) / up;
+        double sum = 0.0;
+        for (size_t j = 0; j < taps; ++j) {
+            // Расстояние от отсчёта окна до идеальной позиции выхода
+            double d = static_cast<double>(j) - (half - 1.0) - frac;
+            double v = cutoff * sinc(cutoff * d) * blackman(d / half);
+            c[j] = static_cast<float>(v);
+            sum += v;
+        }
+        // Единичное усиление на постоянной составляющей для каждой фазы
+        for (size_t j = 0; j < taps; ++j) {
+            c[j] = static_cast<float>(c[j] / sum);
+        }
+    }
+}
+
+size_t Resampler::maxOutput(size_t frames) const
+{
+    if (passthrough) return frames;
+    return (frames * up) / down + 2;
+}
+
+size_t Resampler::process(const short* in, size_t frames, short* out)
+{
+    if (passthrough) {
+        std::copy(in, in + frames, out);
+        return frames;
+    }
+
+    size_t produced = 0;
+    while (frames > 0) {
+        // Блок не больше свободного места в истории
+        size_t chunk = std::min(frames, history.size() - historyLength);
+        produced += processChunk(in, chunk, out + produced);
+        in += chunk * channels;
+        frames -= chunk;
+    }
+    return produced;
+}
+
+size_t Resampler::processChunk(const short* in, size_t frames, short* out)
+{
+    // Сведение в моно и перевод в float
+    float* dst = history.data() + historyLength;
+    const float scale = 1.0f / static_cast<float>(channels);
+    if (channels == 1) {
+        for (size_t i = 0; i < frames; ++i) {
+            dst[i] = static_cast<float>(in[i]);
+        }
+    } else {
+        for (size_t i = 0; i < frames; ++i) {
+            int sum = 0;
+            for (unsigned int ch = 0; ch < channels; ++ch) {
+                sum += in[i * channels + ch];
+            }
+            dst[i] = static_cast<float>(sum) * scale;
+        }
+    }
+    historyLength += frames;
+
+    size_t produced = 0;
+    while (position + taps <= historyLength) {
+        const float* c = coefficients.data() + static_cast<size_t>(phase) * taps;
+        float v = dot(history.data() + position, c, taps);
+        v = std::max(-32768.0f, std::min(32767.0f, v));
+        out[produced++] = static_cast<short>(std::lrintf(v));
+
+        phase += down;
+        position += phase / up;
+        phase %= up;
+    }
+
+    // Сдвигаем необработанный хвост в начало
+    size_t keep = historyLength - std::min(position, historyLength);
+    std::copy(history.begin() + static_cast<std::ptrdiff_t>(historyLength - keep),
+              history.begin() + static_cast<std::ptrdiff_t>(historyLength),
+              history.begin());
+    position -= historyLength - keep;
+    historyLength = keep;
+
+    return produced;
+}
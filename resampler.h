@@ -0,0 +1,61 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+// Полифазный ресемплер на оконном sinc: любая частота и число каналов -> моно с частотой outRate.
+// Свёртка векторизована (AVX2/FMA или SSE на x86 с выбором при запуске, NEON на ARM).
+// Буферы выделяются в configure(), process() на пути звука памяти не выделяет.
+class Resampler
+{
+public:
+    Resampler();
+
+    // maxInputFrames — наибольший блок, который будет передаваться в process()
+    void configure(unsigned int inRate, unsigned int channels, unsigned int outRate, size_t maxInputFrames);
+    void reset();
+
+    // Данные уже моно с нужной частотой — преобразование не требуется
+    bool isPassthrough() const { return passthrough; }
+
+    // Максимальное число выходных отсчётов для блока из frames входных кадров
+    size_t maxOutput(size_t frames) const;
+
+    // Принимает чередующиеся кадры, пишет моно отсчёты в out, возвращает их число
+    size_t process(const short* in, size_t frames, short* out);
+
+    unsigned int inputRate() const { return inRate; }
+    unsigned int inputChannels() const { return channels; }
+    const char* kernelName() const { return kernelLabel; }
+    // Ядро свёртки по имени (scalar, sse, avx2, neon) вместо выбранного при создании — для бенчмарков.
+    // false — ядро не собрано для этой платформы или не поддерживается процессором
+    bool selectKernel(const char* name);
+
+private:
+    typedef float (*DotFn)(const float*, const float*, size_t);
+
+    void buildFilter();
+    size_t processChunk(const short* in, size_t frames, short* out);
+
+    unsigned int inRate;
+    unsigned int outRate;
+    unsigned int channels;
+    bool passthrough;
+
+    // Отношение частот outRate/inRate = up/down (после сокращения на НОД)
+    unsigned int up;
+    unsigned int down;
+    size_t taps;
+
+    std::vector<float> coefficients;    // up фаз по taps коэффициентов подряд
+    std::vector<float> history;         // Хвост предыдущего блока + текущий блок в моно float
+    size_t historyLength;
+    size_t position;                    // Индекс первого отсчёта окна для следующего выхода
+    unsigned int phase;                 // Текущая фаза (0..up-1)
+
+    DotFn dot;
+    const char* kernelLabel;
+};
+
+#endif // RESAMPLER_H
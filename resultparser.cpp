@@ -0,0 +1,486 @@
+#include "resultparser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+const size_t BLOCK = 16;
+
+inline bool isStructural(char c)
+{
+    return c == '"' || c == '\\' || c == '[' || c == ']' || c == '{' || c == '}';
+}
+
+// Битовая маска символов " \ [ ] { } в блоке до 16 байт: полный блок — одним сравнением SSE2
+inline unsigned int structuralMask(const char* p, size_t length)
+{
+#if defined(__SSE2__)
+    if (length == BLOCK) {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i openBracket = _mm_set1_epi8('[');
+        const __m128i closeBracket = _mm_set1_epi8(']');
+        const __m128i openBrace = _mm_set1_epi8('{');
+        const __m128i closeBrace = _mm_set1_epi8('}');
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                         _mm_cmpeq_epi8(chunk, openBracket)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, closeBracket), _mm_cmpeq_epi8(chunk, openBrace)),
+                         _mm_cmpeq_epi8(chunk, closeBrace)));
+        return static_cast<unsigned int>(_mm_movemask_epi8(hits));
+    }
+#endif
+    unsigned int mask = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (isStructural(p[i])) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+// Курсор по тексту JSON; каждый метод сначала пропускает пробелы
+class Cursor
+{
+public:
+    explicit Cursor(std::string_view text)
+        : p(text.data())
+        , end(text.data() + text.size())
+    {
+    }
+
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+            ++p;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (p < end && *p == c) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(JsonString& out)
+    {
+        if (!consume('"')) return false;
+        const char* begin = p;
+        bool escaped = false;
+        while (p < end && *p != '"') {
+            if (*p == '\\') {
+                escaped = true;
+                // Следующий символ экранирован; цифры \uXXXX кавычек не содержат
+                ++p;
+                if (p == end) return false;
+            }
+            ++p;
+        }
+        if (p == end) return false;
+        out.raw = std::string_view(begin, static_cast<size_t>(p - begin));
+        out.escaped = escaped;
+        ++p;
+        return true;
+    }
+
+    bool parseNumber(double& out)
+    {
+        skipSpace();
+        bool negative = false;
+        if (p < end && *p == '-') {
+            negative = true;
+            ++p;
+        }
+        if (p == end || *p < '0' || *p > '9') return false;
+
+        // Мантисса копится целым числом, дробная часть — делением на степень 10 в конце
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int fraction = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (digits < 18) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                ++digits;
+            } else {
+                --fraction;             // Лишние цифры целой части только увеличивают порядок
+            }
+            ++p;
+        }
+        if (p < end && *p == '.') {
+            ++p;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (digits < 18) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    ++digits;
+                    ++fraction;
+                }
+                ++p;
+            }
+        }
+        double value = static_cast<double>(mantissa);
+        if (fraction > 0) {
+            value /= POW10[fraction];
+        } else if (fraction < 0) {
+            value *= std::pow(10.0, -fraction);
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool negativeExponent = false;
+            if (p < end && (*p == '+' || *p == '-')) {
+                negativeExponent = (*p == '-');
+                ++p;
+            }
+            int exponent = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                exponent = exponent * 10 + (*p - '0');
+                ++p;
+            }
+            value *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+        }
+        out = negative ? -value : value;
+        return true;
+    }
+
+    bool skipLiteral(std::string_view literal)
+    {
+        skipSpace();
+        if (static_cast<size_t>(end - p) < literal.size() || std::string_view(p, literal.size()) != literal) {
+            return false;
+        }
+        p += literal.size();
+        return true;
+    }
+
+    bool skipValue()
+    {
+        skipSpace();
+        if (p == end) return false;
+
+        switch (*p) {
+        case '"': {
+            JsonString ignored;
+            return parseString(ignored);
+        }
+        case '{':
+        case '[':
+            return skipContainer();
+        case 't':
+            return skipLiteral("true");
+        case 'f':
+            return skipLiteral("false");
+        case 'n':
+            return skipLiteral("null");
+        default: {
+            double ignored;
+            return parseNumber(ignored);
+        }
+        }
+    }
+
+private:
+    // Объект или массив целиком: считаются только скобки вне строк, содержимое не проверяется.
+    // Текст между структурными символами пропускается блоками — так массив слов проходится
+    // в разы быстрее полного разбора.
+    bool skipContainer()
+    {
+        int depth = 0;
+        bool inString = false;
+        unsigned int carry = 0;         // Экранированный символ в начале следующего блока
+        while (p < end) {
+            size_t length = std::min(BLOCK, static_cast<size_t>(end - p));
+            unsigned int mask = structuralMask(p, length) & ~carry;
+            carry = 0;
+            while (mask) {
+                unsigned int i = static_cast<unsigned int>(__builtin_ctz(mask));
+                mask &= mask - 1;
+                char c = p[i];
+                if (c == '\\') {
+                    if (i + 1 < length) {
+                        mask &= ~(1u << (i + 1));
+                    } else {
+                        carry = 1;
+                    }
+                } else if (c == '"') {
+                    inString = !inString;
+                } else if (inString) {
+                    continue;
+                } else if (c == '[' || c == '{') {
+                    ++depth;
+                } else if (--depth == 0) {
+                    p += i + 1;
+                    return true;
+                }
+            }
+            p += length;
+        }
+        return false;
+    }
+
+    const char* p;
+    const char* end;
+};
+
+// Массив слов [{"conf":..,"end":..,"start":..,"word":".."}, ...] дописывается в result.words
+bool parseWords(Cursor& cursor, RecognitionResult& result, size_t& count)
+{
+    count = 0;
+    if (!cursor.consume('[')) return false;
+    if (cursor.consume(']')) return true;
+
+    do {
+        RecognizedWord word;
+        if (!cursor.consume('{')) return false;
+        if (!cursor.consume('}')) {
+            do {
+                JsonString key;
+                if (!cursor.parseString(key) || !cursor.consume(':')) return false;
+                double number;
+                if (key.raw == "word") {
+                    if (!cursor.parseString(word.word)) return false;
+                } else if (key.raw == "conf") {
+                    if (!cursor.parseNumber(number)) return false;
+                    word.conf = static_cast<float>(number);
+                } else if (key.raw == "start") {
+                    if (!cursor.parseNumber(number)) return false;
+                    word.start = static_cast<float>(number);
+                } else if (key.raw == "end") {
+                    if (!cursor.parseNumber(number)) return false;
+                    word.end = static_cast<float>(number);
+                } else if (!cursor.skipValue()) {
+                    return false;
+                }
+            } while (cursor.consume(','));
+            if (!cursor.consume('}')) return false;
+        }
+
+        if (result.storedWords < RecognitionResult::MaxWords) {
+            result.words[result.storedWords++] = word;
+            ++count;
+        } else {
+            result.truncated = true;
+        }
+    } while (cursor.consume(','));
+    return cursor.consume(']');
+}
+
+// Массив вариантов [{"confidence":..,"result":[...],"text":".."}, ...]
+bool parseAlternatives(Cursor& cursor, RecognitionResult& result, bool withWords)
+{
+    if (!cursor.consume('[')) return false;
+    if (cursor.consume(']')) return true;
+
+    do {
+        RecognitionAlternative alternative;
+        alternative.firstWord = result.storedWords;
+        if (!cursor.consume('{')) return false;
+        if (!cursor.consume('}')) {
+            do {
+                JsonString key;
+                if (!cursor.parseString(key) || !cursor.consume(':')) return false;
+                if (key.raw == "text") {
+                    if (!cursor.parseString(alternative.text)) return false;
+                } else if (key.raw == "confidence") {
+                    if (!cursor.parseNumber(alternative.confidence)) return false;
+                } else if (key.raw == "result" && withWords) {
+                    size_t firstWord = result.storedWords;
+                    if (!parseWords(cursor, result, alternative.wordCount)) return false;
+                    alternative.firstWord = firstWord;
+                } else if (!cursor.skipValue()) {
+                    return false;
+                }
+            } while (cursor.consume(','));
+            if (!cursor.consume('}')) return false;
+        }
+
+        if (result.alternativeCount < RecognitionResult::MaxAlternatives) {
+            result.alternatives[result.alternativeCount++] = alternative;
+        } else {
+            result.truncated = true;
+        }
+    } while (cursor.consume(','));
+    return cursor.consume(']');
+}
+
+void appendUtf8(unsigned int codepoint, char* out, size_t capacity, size_t& length)
+{
+    char buffer[4];
+    size_t n;
+    if (codepoint < 0x80) {
+        buffer[0] = static_cast<char>(codepoint);
+        n = 1;
+    } else if (codepoint < 0x800) {
+        buffer[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+        buffer[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        n = 2;
+    } else if (codepoint < 0x10000) {
+        buffer[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+        buffer[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        buffer[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        n = 3;
+    } else {
+        buffer[0] = static_cast<char>(0xF0 | (codepoint >> 18));
+        buffer[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        buffer[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        buffer[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        n = 4;
+    }
+    for (size_t i = 0; i < n && length < capacity; ++i) {
+        out[length++] = buffer[i];
+    }
+}
+
+bool readHex4(std::string_view text, size_t pos, unsigned int& value)
+{
+    if (pos + 4 > text.size()) return false;
+    value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        int digit = hexValue(text[pos + i]);
+        if (digit < 0) return false;
+        value = (value << 4) | static_cast<unsigned int>(digit);
+    }
+    return true;
+}
+
+} // namespace
+
+size_t JsonString::decode(char* out, size_t capacity) const
+{
+    size_t length = 0;
+    for (size_t i = 0; i < raw.size() && length < capacity; ++i) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 >= raw.size()) {
+            out[length++] = c;
+            continue;
+        }
+
+        char e = raw[++i];
+        switch (e) {
+        case 'n': out[length++] = '\n'; break;
+        case 't': out[length++] = '\t'; break;
+        case 'r': out[length++] = '\r'; break;
+        case 'b': out[length++] = '\b'; break;
+        case 'f': out[length++] = '\f'; break;
+        case 'u': {
+            unsigned int codepoint;
+            if (!readHex4(raw, i + 1, codepoint)) {
+                out[length++] = e;
+                break;
+            }
+            i += 4;
+            // Суррогатная пара UTF-16
+            unsigned int low;
+            if (codepoint >= 0xD800 && codepoint < 0xDC00 && i + 2 < raw.size() && raw[i + 1] == '\\' &&
+                raw[i + 2] == 'u' && readHex4(raw, i + 3, low) && low >= 0xDC00 && low < 0xE000) {
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            }
+            appendUtf8(codepoint, out, capacity, length);
+            break;
+        }
+        default:
+            // \" \\ \/
+            out[length++] = e;
+            break;
+        }
+    }
+    return length;
+}
+
+std::string JsonString::str() const
+{
+    if (!escaped) {
+        return std::string(raw);
+    }
+    // Раскодированный текст не длиннее исходного: \uXXXX (6 байт) даёт не больше 3 байт UTF-8
+    std::string text(raw.size(), '\0');
+    text.resize(decode(&text[0], text.size()));
+    return text;
+}
+
+double RecognitionResult::averageConfidence() const
+{
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < wordCount; ++i) {
+        if (words[i].conf >= 0.0f) {
+            sum += words[i].conf;
+            ++count;
+        }
+    }
+    return count ? sum / count : 0.0;
+}
+
+bool ResultParser::parse(std::string_view json, RecognitionResult& result, bool withWords)
+{
+    result.text = JsonString();
+    result.partial = false;
+    result.truncated = false;
+    result.wordCount = 0;
+    result.storedWords = 0;
+    result.alternativeCount = 0;
+
+    Cursor cursor(json);
+    if (!cursor.consume('{')) return false;
+    if (cursor.consume('}')) return true;
+
+    do {
+        JsonString key;
+        if (!cursor.parseString(key) || !cursor.consume(':')) return false;
+
+        if (key.raw == "text" || key.raw == "partial") {
+            if (!cursor.parseString(result.text)) return false;
+            result.partial = (key.raw == "partial");
+        } else if (withWords && (key.raw == "result" || key.raw == "partial_result")) {
+            size_t firstWord = result.storedWords;
+            size_t count;
+            if (!parseWords(cursor, result, count)) return false;
+            if (firstWord == 0) {
+                result.wordCount = count;
+            }
+        } else if (key.raw == "alternatives") {
+            if (!parseAlternatives(cursor, result, withWords)) return false;
+        } else if (!cursor.skipValue()) {
+            return false;
+        }
+    } while (cursor.consume(','));
+
+    // N-best: основной результат — лучший вариант
+    if (result.alternativeCount > 0 && result.text.empty()) {
+        const RecognitionAlternative& best = result.alternatives[0];
+        result.text = best.text;
+        if (best.firstWord == 0) {
+            result.wordCount = best.wordCount;
+        }
+    }
+    return cursor.consume('}');
+}
+
+std::string resultText(std::string_view json)
+{
+    // Массивы результата велики для стека на каждом частичном результате — держим один на поток
+    static thread_local RecognitionResult result;
+    if (!ResultParser::parse(json, result, false)) {
+        return std::string();
+    }
+    return result.text.str();
+}
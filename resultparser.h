@@ -0,0 +1,70 @@
+#ifndef RESULTPARSER_H
+#define RESULTPARSER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Строка JSON как участок исходного текста, без копии.
+// Если внутри есть escape-последовательности, escaped = true и текст нужно раскодировать.
+struct JsonString {
+    std::string_view raw;
+    bool escaped = false;
+
+    bool empty() const { return raw.empty(); }
+    // Пишет раскодированный UTF-8 в out (не больше capacity байт), возвращает длину
+    size_t decode(char* out, size_t capacity) const;
+    std::string str() const;
+};
+
+// Слово результата с временными метками (vosk_recognizer_set_words)
+struct RecognizedWord {
+    JsonString word;
+    float start = 0.0f;
+    float end = 0.0f;
+    float conf = -1.0f;                 // -1 — уверенность не передана (слова альтернатив)
+};
+
+// Вариант из N-best (vosk_recognizer_set_max_alternatives)
+struct RecognitionAlternative {
+    JsonString text;
+    double confidence = 0.0;
+    size_t firstWord = 0;               // Слова варианта — words[firstWord, firstWord + wordCount)
+    size_t wordCount = 0;
+};
+
+// Разобранный результат Vosk: финальный ("text"), частичный ("partial") или N-best ("alternatives").
+// Все массивы фиксированного размера, строки указывают в исходный JSON — разбор не выделяет память,
+// а результат действителен, пока жив исходный текст.
+struct RecognitionResult {
+    static const size_t MaxWords = 128;
+    static const size_t MaxAlternatives = 10;
+
+    JsonString text;                    // Для N-best — текст лучшего варианта
+    bool partial = false;
+    bool truncated = false;             // Слова или варианты сверх ёмкости отброшены
+
+    size_t wordCount = 0;               // Слова основного результата — первые wordCount элементов words
+    size_t storedWords = 0;             // Всего заполнено элементов words (вместе со словами вариантов)
+    RecognizedWord words[MaxWords];
+
+    size_t alternativeCount = 0;
+    RecognitionAlternative alternatives[MaxAlternatives];
+
+    // Средний conf слов основного результата (0 — нет слов с conf)
+    double averageConfidence() const;
+};
+
+// Однопроходный разбор JSON результатов Vosk поверх string_view.
+// Неизвестные поля пропускаются, экранирование в строках учитывается.
+class ResultParser
+{
+public:
+    // withWords = false — массивы слов пропускаются без разбора (нужен только текст)
+    static bool parse(std::string_view json, RecognitionResult& result, bool withWords = true);
+};
+
+// Текст результата ("text" или "partial") одной строкой, без разбора слов
+std::string resultText(std::string_view json);
+
+#endif // RESULTPARSER_H
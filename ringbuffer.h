@@ -0,0 +1,103 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Кольцевой буфер без блокировок для одного писателя и одного читателя (SPSC).
+// Писатель — поток захвата звука, читатель — поток распознавания.
+// Индексы монотонно растут, позиция в массиве берётся по маске (ёмкость — степень двойки).
+template <typename T>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRingBuffer хранит только тривиально копируемые типы");
+
+public:
+    explicit SpscRingBuffer(size_t minCapacity)
+    {
+        size_t cap = 1;
+        while (cap < minCapacity) {
+            cap <<= 1;
+        }
+        storage.resize(cap);
+        mask = cap - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const { return storage.size(); }
+
+    size_t readAvailable() const
+    {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+    size_t writeAvailable() const { return capacity() - readAvailable(); }
+
+    // --- Сторона писателя ---
+    // Записывает count элементов целиком или не записывает ничего
+    bool push(const T* data, size_t count)
+    {
+        const size_t w = writeIndex.load(std::memory_order_relaxed);
+        const size_t r = readIndex.load(std::memory_order_acquire);
+        if (capacity() - (w - r) < count) {
+            return false;
+        }
+
+        const size_t offset = w & mask;
+        const size_t first = std::min(count, capacity() - offset);
+        std::memcpy(storage.data() + offset, data, first * sizeof(T));
+        std::memcpy(storage.data(), data + first, (count - first) * sizeof(T));
+
+        writeIndex.store(w + count, std::memory_order_release);
+        return true;
+    }
+
+    // --- Сторона читателя ---
+    // Возвращает непрерывный участок готовых данных без копирования.
+    // После обработки участок освобождается вызовом consume().
+    size_t peek(const T** data) const
+    {
+        const size_t r = readIndex.load(std::memory_order_relaxed);
+        const size_t w = writeIndex.load(std::memory_order_acquire);
+        const size_t offset = r & mask;
+        *data = storage.data() + offset;
+        return std::min(w - r, capacity() - offset);
+    }
+
+    void consume(size_t count)
+    {
+        readIndex.store(readIndex.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    size_t pop(T* out, size_t maxCount)
+    {
+        size_t total = 0;
+        while (total < maxCount) {
+            const T* chunk = nullptr;
+            size_t available = peek(&chunk);
+            if (available == 0) {
+                break;
+            }
+            available = std::min(available, maxCount - total);
+            std::memcpy(out + total, chunk, available * sizeof(T));
+            consume(available);
+            total += available;
+        }
+        return total;
+    }
+
+private:
+    std::vector<T> storage;
+    size_t mask = 0;
+    // Индексы на разных линиях кэша, чтобы писатель и читатель не мешали друг другу
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,107 @@
+#include "segmenter.h"
+
+// Пауза по умолчанию: внутри одной команды слова идут почти без перерыва
+#define DEFAULT_PAUSE_SECONDS 0.5
+
+namespace {
+
+struct Conjunction {
+    std::string_view words;
+    size_t wordCount;
+    bool sequential;
+};
+
+// Связки между намерениями, длинные раньше коротких
+const Conjunction CONJUNCTIONS[] = {
+    {"после этого", 2, true}, {"после чего", 2, true},
+    {"а потом", 2, true}, {"и потом", 2, true}, {"а затем", 2, true}, {"и затем", 2, true},
+    {"а также", 2, false},
+    {"потом", 1, true}, {"затем", 1, true},
+    {"и", 1, false},
+};
+
+struct Token {
+    size_t start;
+    size_t end;
+};
+
+} // namespace
+
+UtteranceSegmenter::UtteranceSegmenter()
+    : pause(DEFAULT_PAUSE_SECONDS)
+{
+}
+
+size_t UtteranceSegmenter::split(std::string_view folded, const RecognizedWord* words, size_t wordCount,
+                                 UtteranceSegment* segments) const
+{
+    Token tokens[MaxWords];
+    size_t tokenCount = 0;
+    bool truncated = false;
+    size_t pos = 0;
+    while (pos < folded.size()) {
+        size_t end = folded.find(' ', pos);
+        if (end == std::string_view::npos) end = folded.size();
+        if (tokenCount == MaxWords) {
+            truncated = true;
+            break;
+        }
+        tokens[tokenCount++] = Token{pos, end};
+        pos = end + 1;
+    }
+    if (tokenCount == 0) return 0;
+
+    // Метки времени годятся, только если слова результата совпадают со словами текста один к одному
+    bool timed = words && pause > 0.0 && !truncated && wordCount == tokenCount;
+
+    size_t count = 0;
+    size_t first = 0;                   // Первое слово текущего куска
+    bool sequential = false;
+    auto close = [&](size_t last) {
+        UtteranceSegment& segment = segments[count++];
+        segment.start = tokens[first].start;
+        segment.end = tokens[last - 1].end;
+        segment.firstWord = first;
+        segment.wordCount = last - first;
+        segment.sequential = sequential;
+    };
+
+    for (size_t i = 0; i < tokenCount; ++i) {
+        // Связка, начинающаяся со слова i
+        const Conjunction* conjunction = nullptr;
+        for (const auto& candidate : CONJUNCTIONS) {
+            size_t last = i + candidate.wordCount - 1;
+            if (last < tokenCount &&
+                folded.substr(tokens[i].start, tokens[last].end - tokens[i].start) == candidate.words) {
+                conjunction = &candidate;
+                break;
+            }
+        }
+        // Последний кусок забирает остаток фразы
+        bool room = count + 1 < MaxSegments;
+
+        if (conjunction && (i > first || count > 0) && room) {
+            if (i > first) {
+                close(i);
+                sequential = false;
+            }
+            // "открой браузер, (пауза) потом почту" — связка сразу после паузы тоже делает кусок зависимым
+            sequential = sequential || conjunction->sequential;
+            first = i + conjunction->wordCount;
+            i = first - 1;
+            continue;
+        }
+        if (timed && i > first && room && words[i].start - words[i - 1].end >= pause) {
+            close(i);
+            sequential = false;
+            first = i;
+        }
+    }
+    if (first < tokenCount) {
+        close(tokenCount);
+    }
+    if (count > 0 && truncated) {
+        segments[count - 1].end = folded.size();
+    }
+    return count;
+}
@@ -0,0 +1,44 @@
+#ifndef SEGMENTER_H
+#define SEGMENTER_H
+
+#include "resultparser.h"
+#include <cstddef>
+#include <string_view>
+
+// Кусок фразы с отдельным намерением
+struct UtteranceSegment {
+    size_t start = 0;                   // Байты куска в свёрнутом тексте
+    size_t end = 0;
+    size_t firstWord = 0;               // Слова куска [firstWord, firstWord + wordCount)
+    size_t wordCount = 0;
+    bool sequential = false;            // Перед куском стоит "потом"/"затем": выполнять после предыдущих
+};
+
+// Деление фразы на намерения: "открой браузер и скажи привет" → "открой браузер", "скажи привет".
+// Границы — связки ("и", "а также" — независимые намерения; "потом", "затем", "после этого" —
+// зависимые) и паузы между словами по меткам времени vosk_recognizer_set_words.
+// Это только кандидаты: кусок, в котором не нашлось команды, присоединяется обратно (CommandScorer),
+// поэтому "две минуты и десять секунд" или "свет и музыку" в одном ключевом слове не разрываются.
+class UtteranceSegmenter
+{
+public:
+    static const size_t MaxSegments = 8;
+    static const size_t MaxWords = 64;
+
+    UtteranceSegmenter();
+
+    // Пауза, начиная с которой между словами проходит граница (0 — паузы не учитываются)
+    void setPause(double seconds) { pause = seconds; }
+    double pauseSeconds() const { return pause; }
+
+    // folded — свёрнутый текст (foldText); words — слова того же результата с метками времени
+    // (могут отсутствовать: words = nullptr или число слов не совпадает с текстом — тогда только связки).
+    // Возвращает число кусков, не больше MaxSegments
+    size_t split(std::string_view folded, const RecognizedWord* words, size_t wordCount,
+                 UtteranceSegment* segments) const;
+
+private:
+    double pause;
+};
+
+#endif // SEGMENTER_H
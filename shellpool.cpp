@@ -0,0 +1,224 @@
+#include "shellpool.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+extern char **environ;
+
+#define SHELL_PATH "/bin/bash"
+
+namespace {
+
+// Программа оболочки. Переменные с префиксом __va_ удаляются до выполнения скрипта.
+// source — только для скриптов с #!/bin/bash: у /bin/sh и остальных интерпретаторов свои правила.
+// BASH_ARGV0 (bash 5) даёт скрипту привычный $0; в старом bash скрипт запускается через exec
+const char SHELL_PROGRAM[] = R"(IFS= read -r -d '' __va_path || exit 0
+IFS= read -r -d '' __va_count
+__va_env=()
+for ((__va_i = 0; __va_i < __va_count; __va_i++)); do IFS= read -r -d '' __va_v; __va_env+=("$__va_v"); done
+IFS= read -r -d '' __va_count
+__va_args=()
+for ((__va_i = 0; __va_i < __va_count; __va_i++)); do IFS= read -r -d '' __va_v; __va_args+=("$__va_v"); done
+exec </dev/null
+for __va_v in "${__va_env[@]}"; do export "$__va_v"; done
+IFS= read -r __va_line < "$__va_path"
+if (( BASH_VERSINFO[0] >= 5 )); then
+    case $__va_line in
+        '#!/bin/bash'*|'#!/usr/bin/bash'*|'#!/usr/bin/env bash'*)
+            BASH_ARGV0=$__va_path
+            set -- "${__va_args[@]}"
+            unset -v __va_path __va_count __va_env __va_args __va_i __va_v __va_line
+            . "$0"
+            exit
+            ;;
+    esac
+fi
+[[ -x $__va_path ]] && exec "$__va_path" "${__va_args[@]}"
+exec /bin/sh "$__va_path" "${__va_args[@]}"
+)";
+
+bool writeAll(int fd, const std::string& data)
+{
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Запись в канал упавшей оболочки: SIGPIPE заблокирован в потоке, ожидающий сигнал снимается здесь
+void discardSigpipe()
+{
+    sigset_t pipeSet;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    timespec zero{0, 0};
+    while (sigtimedwait(&pipeSet, nullptr, &zero) == SIGPIPE) {
+    }
+}
+
+} // namespace
+
+ShellPool::ShellPool()
+    : restartCount(0)
+{
+}
+
+ShellPool::~ShellPool()
+{
+    stop();
+}
+
+bool ShellPool::start(size_t count, std::string& error)
+{
+    stop();
+    if (count == 0) return true;
+    if (access(SHELL_PATH, X_OK) != 0) {
+        error = SHELL_PATH " не найден";
+        return false;
+    }
+
+    // Запись в канал оболочки, которая только что упала, не должна завершить приложение
+    sigset_t pipeSet;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, nullptr);
+
+    shells.resize(count);
+    for (auto& shell : shells) {
+        if (!spawnShell(shell, error)) {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShellPool::stop()
+{
+    for (auto& shell : shells) {
+        closeShell(shell);
+    }
+    shells.clear();
+}
+
+bool ShellPool::hasVacancy() const
+{
+    return std::any_of(shells.begin(), shells.end(), [](const Shell& shell) { return shell.pid <= 0; });
+}
+
+bool ShellPool::spawnShell(Shell& shell, std::string& error)
+{
+    int request[2];
+    if (pipe2(request, O_CLOEXEC) != 0) {
+        error = std::string("pipe: ") + strerror(errno);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, request[0], STDIN_FILENO);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    // Своя группа — та же, что у скрипта из ProcessExecutor::spawn(): таймаут завершает её целиком
+    posix_spawnattr_setpgroup(&attr, 0);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    for (int signal : {SIGPIPE, SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGCHLD, SIGUSR1, SIGUSR2}) {
+        sigaddset(&defaults, signal);
+    }
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    char *argv[] = {const_cast<char*>(SHELL_PATH), const_cast<char*>("--noprofile"), const_cast<char*>("--norc"),
+                    const_cast<char*>("-c"), const_cast<char*>(SHELL_PROGRAM),
+                    const_cast<char*>("voice-assistant-shell"), nullptr};
+    pid_t pid = -1;
+    int err = posix_spawn(&pid, SHELL_PATH, &actions, &attr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(request[0]);
+    if (err != 0) {
+        error = std::string("posix_spawn " SHELL_PATH ": ") + strerror(err);
+        close(request[1]);
+        return false;
+    }
+
+    shell.pid = pid;
+    shell.requestFd = request[1];
+    return true;
+}
+
+void ShellPool::closeShell(Shell& shell)
+{
+    // Без запроса оболочка выходит сама по концу канала; SIGKILL — на случай, если она занята чем-то ещё
+    if (shell.requestFd >= 0) close(shell.requestFd);
+    if (shell.pid > 0) {
+        kill(shell.pid, SIGKILL);
+        waitpid(shell.pid, nullptr, 0);
+    }
+    shell = Shell();
+}
+
+pid_t ShellPool::run(const std::string& path, const std::vector<std::string>& arguments,
+                     const std::vector<std::string>& environment)
+{
+    std::string message;
+    message.reserve(path.size() + 64);
+    message.append(path).push_back('\0');
+    message.append(std::to_string(environment.size())).push_back('\0');
+    for (const auto& variable : environment) {
+        message.append(variable).push_back('\0');
+    }
+    message.append(std::to_string(arguments.size())).push_back('\0');
+    for (const auto& argument : arguments) {
+        message.append(argument).push_back('\0');
+    }
+
+    for (auto& shell : shells) {
+        if (shell.pid <= 0) continue;
+        if (writeAll(shell.requestFd, message)) {
+            // Оболочка стала процессом скрипта — слот освобождается для новой
+            pid_t pid = shell.pid;
+            close(shell.requestFd);
+            shell = Shell();
+            return pid;
+        }
+        // Оболочка упала в простое
+        discardSigpipe();
+        closeShell(shell);
+        ++restartCount;
+    }
+    return -1;
+}
+
+bool ShellPool::replenish()
+{
+    for (auto& shell : shells) {
+        if (shell.pid > 0) {
+            if (waitpid(shell.pid, nullptr, WNOHANG) != shell.pid) continue;
+            // Упала в простое: процесс уже собран, остаётся канал
+            close(shell.requestFd);
+            shell = Shell();
+            ++restartCount;
+        }
+        std::string error;
+        if (!spawnShell(shell, error)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef SHELLPOOL_H
+#define SHELLPOOL_H
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Заранее запущенные bash, каждый ждёт в канале один запрос: путь скрипта, окружение и аргументы.
+// Получив его, оболочка сама становится процессом скрипта: bash-скрипт выполняется в ней же (source),
+// без fork и exec, остальные — через exec. Запуск скрипта обходится записью в канал вместо
+// fork/posix_spawn из большого процесса приложения, exec /bin/sh и старта интерпретатора.
+// Процесс скрипта остаётся прямым потомком приложения в своей группе (waitpid, pidfd, kill(-pid)),
+// место занятой оболочки сразу занимает новая. Все методы вызываются из одного потока (исполнителя).
+class ShellPool
+{
+public:
+    ShellPool();
+    ~ShellPool();
+
+    bool start(size_t count, std::string& error);
+    void stop();
+    size_t size() const { return shells.size(); }
+    // Есть места ушедших в скрипты или упавших оболочек
+    bool hasVacancy() const;
+
+    // Передаёт скрипт свободной оболочке; pid процесса скрипта или -1, если свободных нет
+    pid_t run(const std::string& path, const std::vector<std::string>& arguments,
+              const std::vector<std::string>& environment);
+    // Запускает оболочки на свободные места и на место упавших в простое; false — запустить не удалось
+    bool replenish();
+
+    uint64_t restarts() const { return restartCount; }
+
+private:
+    struct Shell {
+        pid_t pid = -1;
+        int requestFd = -1;             // Запрос: путь, число переменных, переменные, число аргументов, аргументы — через \0
+    };
+
+    bool spawnShell(Shell& shell, std::string& error);
+    void closeShell(Shell& shell);
+
+    std::vector<Shell> shells;
+    uint64_t restartCount;
+};
+
+#endif // SHELLPOOL_H
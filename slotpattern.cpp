@@ -0,0 +1,198 @@
+#include "slotpattern.h"
+#include "numeralparser.h"
+#include <algorithm>
+
+namespace {
+
+// Имена типов в # WORDS: английские и русские
+const struct {
+    const char* name;
+    SlotType type;
+} TYPE_NAMES[] = {
+    {"number", SlotType::Number}, {"число", SlotType::Number},
+    {"duration", SlotType::Duration}, {"время", SlotType::Duration},
+    {"text", SlotType::Text}, {"текст", SlotType::Text},
+};
+
+std::string_view trimmed(std::string_view text)
+{
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+    return text;
+}
+
+bool validName(std::string_view name)
+{
+    if (name.empty()) return false;
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+    });
+}
+
+// Слова шаблона стоят в тексте с позиции pos целиком
+bool wordsAt(std::string_view text, size_t pos, std::string_view words)
+{
+    return text.compare(pos, words.size(), words) == 0 &&
+           (pos + words.size() == text.size() || text[pos + words.size()] == ' ');
+}
+
+} // namespace
+
+const char* SlotPattern::typeName(SlotType type)
+{
+    switch (type) {
+    case SlotType::Number: return "number";
+    case SlotType::Duration: return "duration";
+    case SlotType::Text: return "text";
+    }
+    return "";
+}
+
+bool SlotPattern::parse(std::string_view keyword, std::string& error)
+{
+    headText.clear();
+    headWordCount = 0;
+    tail.clear();
+
+    size_t pos = 0;
+    while (pos < keyword.size()) {
+        size_t open = keyword.find('{', pos);
+        std::string_view words = trimmed(keyword.substr(pos, open == std::string_view::npos ? std::string_view::npos
+                                                                                            : open - pos));
+        if (!words.empty()) {
+            if (headText.empty() && tail.empty()) {
+                headText = std::string(words);
+            } else {
+                Element element;
+                element.text = std::string(words);
+                tail.push_back(element);
+            }
+        }
+        if (open == std::string_view::npos) break;
+
+        if (headText.empty()) {
+            error = "шаблон должен начинаться со слов, а не с параметра";
+            return false;
+        }
+        size_t close = keyword.find('}', open);
+        if (close == std::string_view::npos) {
+            error = "нет закрывающей скобки }";
+            return false;
+        }
+
+        std::string_view spec = trimmed(keyword.substr(open + 1, close - open - 1));
+        std::string_view typeText = spec;
+        std::string_view name;
+        size_t colon = spec.find(':');
+        if (colon != std::string_view::npos) {
+            name = trimmed(spec.substr(0, colon));
+            typeText = trimmed(spec.substr(colon + 1));
+        }
+
+        Element element;
+        element.slot = true;
+        bool known = false;
+        for (const auto& entry : TYPE_NAMES) {
+            if (typeText == entry.name) {
+                element.type = entry.type;
+                known = true;
+                break;
+            }
+        }
+        if (!known) {
+            error = "неизвестный тип параметра {" + std::string(spec) + "}";
+            return false;
+        }
+        element.text = name.empty() ? std::string(typeName(element.type)) : std::string(name);
+        if (!validName(element.text)) {
+            error = "имя параметра \"" + element.text + "\" должно состоять из латиницы, цифр и _";
+            return false;
+        }
+        for (const auto& other : tail) {
+            if (other.slot && other.text == element.text) {
+                error = "параметр \"" + element.text + "\" встречается дважды";
+                return false;
+            }
+        }
+        // Конец свободного текста определяется по следующим словам шаблона
+        if (!tail.empty() && tail.back().slot && tail.back().type == SlotType::Text) {
+            error = "после {text} должны идти слова шаблона";
+            return false;
+        }
+        tail.push_back(element);
+        pos = close + 1;
+    }
+
+    if (headText.empty()) {
+        error = "пустой шаблон";
+        return false;
+    }
+    headWordCount = static_cast<size_t>(std::count(headText.begin(), headText.end(), ' ')) + 1;
+    return true;
+}
+
+bool SlotPattern::uses(SlotType type) const
+{
+    return std::any_of(tail.begin(), tail.end(), [type](const Element& element) {
+        return element.slot && element.type == type;
+    });
+}
+
+std::vector<std::string> SlotPattern::literalWords() const
+{
+    std::vector<std::string> words;
+    for (const auto& element : tail) {
+        if (!element.slot) {
+            words.push_back(element.text);
+        }
+    }
+    return words;
+}
+
+bool SlotPattern::extract(std::string_view text, size_t from, std::vector<SlotValue>& values) const
+{
+    values.clear();
+    size_t pos = std::min(from, text.size());
+    for (size_t i = 0; i < tail.size(); ++i) {
+        const Element& element = tail[i];
+        if (pos < text.size() && text[pos] == ' ') ++pos;
+
+        if (!element.slot) {
+            if (!wordsAt(text, pos, element.text)) return false;
+            pos += element.text.size();
+            continue;
+        }
+
+        SlotValue value;
+        value.name = element.text;
+        if (element.type == SlotType::Text) {
+            size_t end = text.size();
+            if (i + 1 < tail.size()) {
+                // Следующий элемент — слова шаблона (проверено в parse)
+                const std::string& next = tail[i + 1].text;
+                end = std::string_view::npos;
+                for (size_t at = text.find(next, pos); at != std::string_view::npos; at = text.find(next, at + 1)) {
+                    if (at > pos && text[at - 1] == ' ' && wordsAt(text, at, next)) {
+                        end = at - 1;
+                        break;
+                    }
+                }
+                if (end == std::string_view::npos) return false;
+            }
+            std::string_view captured = trimmed(text.substr(pos, end - pos));
+            if (captured.empty()) return false;
+            value.value = std::string(captured);
+            pos = end;
+        } else {
+            int64_t number;
+            size_t length = element.type == SlotType::Number
+                                ? NumeralParser::parseNumber(text.substr(pos), number)
+                                : NumeralParser::parseDuration(text.substr(pos), number);
+            if (length == 0) return false;
+            value.value = std::to_string(number);
+            pos += length;
+        }
+        values.push_back(value);
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef SLOTPATTERN_H
+#define SLOTPATTERN_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class SlotType {
+    Number,                             // Целое число: "пятьдесят" → 50
+    Duration,                           // Длительность в секундах: "пять минут" → 300
+    Text                                // Свободный текст до следующего слова шаблона или до конца фразы
+};
+
+// Значение параметра, извлечённое из фразы
+struct SlotValue {
+    std::string name;
+    std::string value;
+};
+
+// Ключевое слово с параметрами из # WORDS: "громкость {number}", "таймер на {timer:duration}",
+// "напомни {text} через {duration}". {тип} или {имя:тип}, имя — латиница, цифры и "_".
+// Команда ищется по словам до первого параметра (head), остальное разбирается после совпадения.
+// Ключевое слово без параметров — шаблон из одного head.
+class SlotPattern
+{
+public:
+    // keyword уже свёрнут (foldText); false — ошибка синтаксиса, описание в error
+    bool parse(std::string_view keyword, std::string& error);
+
+    const std::string& head() const { return headText; }
+    size_t headWords() const { return headWordCount; }
+    bool hasSlots() const { return !tail.empty(); }
+    bool uses(SlotType type) const;
+    // Слова шаблона после head (для грамматики распознавателя)
+    std::vector<std::string> literalWords() const;
+
+    // text — свёрнутый текст, from — позиция сразу за совпавшими словами head
+    bool extract(std::string_view text, size_t from, std::vector<SlotValue>& values) const;
+
+    static const char* typeName(SlotType type);
+
+private:
+    struct Element {
+        bool slot = false;
+        SlotType type = SlotType::Text;
+        std::string text;               // Имя параметра или слова шаблона
+    };
+
+    std::string headText;
+    size_t headWordCount = 0;
+    std::vector<Element> tail;
+};
+
+#endif // SLOTPATTERN_H
@@ -0,0 +1,492 @@
+#include "streamengine.h"
+#include "prerollbuffer.h"
+#include "resampler.h"
+#include "resultparser.h"
+#include "ringbuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define STREAM_SAMPLE_RATE 16000
+#define STREAM_VAD_FRAME (STREAM_SAMPLE_RATE / 50)     // 20 мс
+#define SOCKET_RING_SAMPLES (STREAM_SAMPLE_RATE * 2)   // 2 с звука из сокета
+#define SOCKET_READ_SAMPLES (STREAM_SAMPLE_RATE / 50)
+
+struct StreamEngine::Stream {
+    StreamConfig config;
+
+    // Источник: либо захват ALSA, либо сокет со своим кольцевым буфером
+    std::unique_ptr<AudioCapture> capture;
+    std::unique_ptr<SpscRingBuffer<short>> ring;
+    int listenFd = -1;
+    std::thread reader;
+
+    Resampler resampler;
+    std::vector<short> resampled;
+    std::vector<short> splitFrame;
+    size_t maxChunkFrames = 0;
+    VoiceActivityDetector vad;
+    PreRollBuffer preRoll;
+    VoskRecognizer* recognizer = nullptr;
+
+    std::mutex grammarMutex;
+    std::string newGrammar;
+    std::atomic<bool> grammarChanged{false};
+
+    // Задача потока уже стоит в пуле или выполняется
+    std::atomic<bool> scheduled{false};
+    std::atomic<uint64_t> droppedSamples{0};
+    StreamMetrics metrics;
+
+    size_t peek(const short** data) const { return capture ? capture->peek(data) : ring->peek(data); }
+    void consume(size_t count)
+    {
+        if (capture) {
+            capture->consume(count);
+        } else {
+            ring->consume(count);
+        }
+    }
+};
+
+static uint64_t threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point begin)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count());
+}
+
+StreamEngine::StreamEngine(QObject *parent)
+    : QObject(parent)
+    , stopFd(-1)
+    , running(false)
+{
+}
+
+StreamEngine::~StreamEngine()
+{
+    stop();
+}
+
+bool StreamEngine::parseSource(const std::string& name, const std::string& spec, StreamConfig& config)
+{
+    config.name = name;
+    if (spec.compare(0, 5, "alsa:") == 0) {
+        config.type = StreamSourceType::Alsa;
+        config.address = spec.substr(5);
+    } else if (spec.compare(0, 5, "unix:") == 0) {
+        config.type = StreamSourceType::Socket;
+        config.address = spec.substr(5);
+    } else {
+        return false;
+    }
+    return !config.address.empty();
+}
+
+bool StreamEngine::start(VoskModel* model, const std::vector<StreamConfig>& configs,
+                         const StreamEngineOptions& engineOptions, StreamDispatcher streamDispatcher)
+{
+    if (running) return true;
+
+    options = engineOptions;
+    dispatcher = streamDispatcher;
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd < 0) {
+        emit logMessage(QString("Не удалось создать eventfd: %1").arg(strerror(errno)));
+        return false;
+    }
+    pool = std::make_unique<WorkStealingPool>(options.threads);
+
+    for (const auto& config : configs) {
+        auto stream = std::make_unique<Stream>();
+        stream->config = config;
+
+        stream->recognizer = options.grammar.empty()
+                                 ? vosk_recognizer_new(model, STREAM_SAMPLE_RATE)
+                                 : vosk_recognizer_new_grm(model, STREAM_SAMPLE_RATE, options.grammar.c_str());
+        if (!stream->recognizer) {
+            emit logMessage(QString("Поток %1: не удалось создать распознаватель")
+                            .arg(QString::fromStdString(config.name)));
+            continue;
+        }
+        // Слова с conf — для оценки команд, как у основного распознавателя
+        vosk_recognizer_set_words(stream->recognizer, 1);
+        stream->vad.configure(options.vad);
+        stream->preRoll.configure(static_cast<size_t>(STREAM_SAMPLE_RATE) * options.preRollMs / 1000);
+
+        if (!openSource(stream.get())) {
+            vosk_recognizer_free(stream->recognizer);
+            continue;
+        }
+        streams.push_back(std::move(stream));
+    }
+
+    // Сокеты начинают читать только после того, как список потоков больше не меняется
+    for (auto& stream : streams) {
+        if (stream->config.type == StreamSourceType::Socket) {
+            stream->reader = std::thread(&StreamEngine::socketLoop, this, stream.get());
+        }
+    }
+
+    if (streams.empty()) {
+        emit logMessage(QString("Не запущен ни один из %1 дополнительных потоков распознавания").arg(configs.size()));
+        pool.reset();
+        close(stopFd);
+        stopFd = -1;
+        return false;
+    }
+
+    running = true;
+    emit logMessage(QString("Дополнительных потоков распознавания: %1, потоков пула: %2")
+                    .arg(streams.size()).arg(pool->threadCount()));
+    return true;
+}
+
+void StreamEngine::setGrammar(const std::string& grammar)
+{
+    // Потоки свободной речи остаются без грамматики
+    if (!running || options.grammar.empty()) return;
+    options.grammar = grammar;
+    for (auto& stream : streams) {
+        std::lock_guard<std::mutex> lock(stream->grammarMutex);
+        stream->newGrammar = grammar;
+        stream->grammarChanged.store(true, std::memory_order_release);
+    }
+}
+
+bool StreamEngine::openSource(Stream* stream)
+{
+    const QString name = QString::fromStdString(stream->config.name);
+
+    if (stream->config.type == StreamSourceType::Alsa) {
+        stream->capture = std::make_unique<AudioCapture>();
+        connect(stream->capture.get(), &AudioCapture::logMessage, this, [this, name](const QString& message) {
+            emit logMessage(QString("[%1] %2").arg(name, message));
+        });
+        // Поток захвата сам ставит задачу в пул, минуя цикл событий
+        connect(stream->capture.get(), &AudioCapture::framesAvailable, this, [this, stream]() {
+            schedule(stream);
+        }, Qt::DirectConnection);
+        // Остальные потоки продолжают работу, этот замолкает до перезапуска ассистента
+        connect(stream->capture.get(), &AudioCapture::captureFailed, this, [this, name]() {
+            emit logMessage(QString("Поток %1: захват прекращён из-за ошибки устройства").arg(name));
+        });
+
+        CaptureOptions captureOptions = options.capture;
+        captureOptions.device = stream->config.address;
+        captureOptions.sampleRate = STREAM_SAMPLE_RATE;
+        if (!stream->capture->start(captureOptions)) {
+            return false;
+        }
+
+        stream->maxChunkFrames = stream->capture->frameSamples() / stream->capture->channelCount() * 4;
+        stream->resampler.configure(stream->capture->sampleRate(), stream->capture->channelCount(),
+                                    STREAM_SAMPLE_RATE, stream->maxChunkFrames);
+        stream->splitFrame.assign(stream->capture->channelCount(), 0);
+    } else {
+        stream->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        struct sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (stream->listenFd < 0 || stream->config.address.size() >= sizeof(address.sun_path)) {
+            emit logMessage(QString("Поток %1: неверный путь сокета %2")
+                            .arg(name, QString::fromStdString(stream->config.address)));
+            closeSource(stream);
+            return false;
+        }
+        std::strncpy(address.sun_path, stream->config.address.c_str(), sizeof(address.sun_path) - 1);
+        // Сокет от предыдущего запуска мешает bind()
+        unlink(stream->config.address.c_str());
+        if (bind(stream->listenFd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(stream->listenFd, 1) != 0) {
+            emit logMessage(QString("Поток %1: не удалось открыть сокет %2: %3")
+                            .arg(name, QString::fromStdString(stream->config.address), strerror(errno)));
+            closeSource(stream);
+            return false;
+        }
+
+        stream->ring = std::make_unique<SpscRingBuffer<short>>(SOCKET_RING_SAMPLES);
+        stream->maxChunkFrames = SOCKET_READ_SAMPLES * 4;
+        stream->resampler.configure(STREAM_SAMPLE_RATE, 1, STREAM_SAMPLE_RATE, stream->maxChunkFrames);
+        stream->splitFrame.assign(1, 0);
+    }
+
+    stream->resampled.assign(stream->resampler.maxOutput(stream->maxChunkFrames), 0);
+    emit logMessage(QString("Поток %1: %2 %3")
+                    .arg(name)
+                    .arg(stream->config.type == StreamSourceType::Alsa ? "устройство" : "сокет")
+                    .arg(QString::fromStdString(stream->config.address)));
+    return true;
+}
+
+void StreamEngine::closeSource(Stream* stream)
+{
+    if (stream->capture) {
+        stream->capture->stop();
+    }
+    if (stream->reader.joinable()) {
+        stream->reader.join();
+    }
+    if (stream->listenFd >= 0) {
+        close(stream->listenFd);
+        stream->listenFd = -1;
+        unlink(stream->config.address.c_str());
+    }
+}
+
+void StreamEngine::stop()
+{
+    if (!running) return;
+    running = false;
+
+    // Сначала замолкают источники, затем пул дорабатывает поставленные задачи
+    uint64_t one = 1;
+    if (write(stopFd, &one, sizeof(one)) < 0) {
+        // eventfd не переполнится одной записью
+    }
+    for (auto& stream : streams) {
+        closeSource(stream.get());
+    }
+    pool->shutdown();
+    logMetrics();
+    pool.reset();
+
+    for (auto& stream : streams) {
+        vosk_recognizer_free(stream->recognizer);
+    }
+    streams.clear();
+    close(stopFd);
+    stopFd = -1;
+}
+
+void StreamEngine::socketLoop(Stream* stream)
+{
+    const QString name = QString::fromStdString(stream->config.name);
+    std::vector<short> buffer(SOCKET_READ_SAMPLES);
+    char* bytes = reinterpret_cast<char*>(buffer.data());
+    const size_t capacityBytes = buffer.size() * sizeof(short);
+    size_t carry = 0;                   // Непарный байт от предыдущего чтения
+    int client = -1;
+
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = stopFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = client >= 0 ? client : stream->listenFd;
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        if (client < 0) {
+            client = accept4(stream->listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0) {
+                emit logMessage(QString("Поток %1: источник подключился").arg(name));
+            }
+            continue;
+        }
+
+        ssize_t n = read(client, bytes + carry, capacityBytes - carry);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            close(client);
+            client = -1;
+            carry = 0;
+            emit logMessage(QString("Поток %1: источник отключился").arg(name));
+            continue;
+        }
+
+        size_t total = carry + static_cast<size_t>(n);
+        size_t samples = total / sizeof(short);
+        // Распознавание не успевает — отбрасываем свежий блок целиком, как и захват ALSA
+        if (!stream->ring->push(buffer.data(), samples)) {
+            stream->droppedSamples.fetch_add(samples, std::memory_order_relaxed);
+        }
+        carry = total % sizeof(short);
+        if (carry) {
+            bytes[0] = bytes[total - 1];
+        }
+        schedule(stream);
+    }
+
+    if (client >= 0) {
+        close(client);
+    }
+}
+
+void StreamEngine::schedule(Stream* stream)
+{
+    if (stream->scheduled.exchange(true, std::memory_order_acq_rel)) return;
+    pool->submit([this, stream]() { pump(stream); });
+}
+
+void StreamEngine::pump(Stream* stream)
+{
+    uint64_t cpuStart = threadCpuNs();
+    for (;;) {
+        drain(stream);
+        stream->scheduled.store(false, std::memory_order_release);
+
+        // Данные могли прийти между последним разбором и сбросом флага
+        const short* data = nullptr;
+        if (stream->peek(&data) == 0 || stream->scheduled.exchange(true, std::memory_order_acq_rel)) {
+            break;
+        }
+    }
+    stream->metrics.cpuNs += threadCpuNs() - cpuStart;
+}
+
+void StreamEngine::drain(Stream* stream)
+{
+    if (stream->capture) {
+        stream->capture->rearmNotification();
+    }
+
+    // Распознаватель не потокобезопасен — грамматика меняется только в задаче потока
+    if (stream->grammarChanged.load(std::memory_order_acquire)) {
+        std::string grammar;
+        {
+            std::lock_guard<std::mutex> lock(stream->grammarMutex);
+            grammar.swap(stream->newGrammar);
+            stream->grammarChanged.store(false, std::memory_order_relaxed);
+        }
+        vosk_recognizer_set_grm(stream->recognizer, grammar.c_str());
+    }
+
+    const size_t channels = stream->resampler.inputChannels();
+    const short* samples = nullptr;
+    size_t count;
+    while ((count = stream->peek(&samples)) > 0) {
+        if (stream->resampler.isPassthrough()) {
+            feed(stream, samples, count);
+            stream->consume(count);
+            continue;
+        }
+
+        size_t frames = std::min(count / channels, stream->maxChunkFrames);
+        const bool split = (frames == 0);
+        if (split) {
+            // Кадр разорван концом кольцевого буфера — собираем его отдельно
+            size_t taken = 0;
+            while (taken < channels) {
+                const short* part = nullptr;
+                size_t n = std::min(stream->peek(&part), channels - taken);
+                std::copy(part, part + n, stream->splitFrame.begin() + static_cast<std::ptrdiff_t>(taken));
+                stream->consume(n);
+                taken += n;
+            }
+            samples = stream->splitFrame.data();
+            frames = 1;
+        }
+
+        size_t produced = stream->resampler.process(samples, frames, stream->resampled.data());
+        if (!split) {
+            stream->consume(frames * channels);
+        }
+        feed(stream, stream->resampled.data(), produced);
+    }
+}
+
+void StreamEngine::feed(Stream* stream, const short* samples, size_t count)
+{
+    stream->metrics.audioSamples += count;
+    if (!options.vadEnabled) {
+        accept(stream, samples, count);
+        return;
+    }
+
+    for (size_t offset = 0; offset < count; offset += STREAM_VAD_FRAME) {
+        size_t n = std::min<size_t>(STREAM_VAD_FRAME, count - offset);
+        bool wasSpeech = stream->vad.inSpeech();
+        switch (stream->vad.process(samples + offset, n)) {
+        case VoiceActivityDetector::Speech:
+            if (!wasSpeech) {
+                stream->preRoll.forEachSpan([this, stream](const short* data, size_t length) {
+                    accept(stream, data, length);
+                });
+                stream->preRoll.clear();
+            }
+            accept(stream, samples + offset, n);
+            break;
+        case VoiceActivityDetector::SpeechEnd: {
+            accept(stream, samples + offset, n);
+            auto begin = std::chrono::steady_clock::now();
+            const char* result = vosk_recognizer_final_result(stream->recognizer);
+            stream->metrics.decodeNs += elapsedNs(begin);
+            finishUtterance(stream, result);
+            break;
+        }
+        case VoiceActivityDetector::Silence:
+            stream->preRoll.append(samples + offset, n);
+            break;
+        }
+    }
+}
+
+void StreamEngine::accept(Stream* stream, const short* samples, size_t count)
+{
+    if (count == 0) return;
+    auto begin = std::chrono::steady_clock::now();
+    bool final = vosk_recognizer_accept_waveform_s(stream->recognizer, samples, static_cast<int>(count)) > 0;
+    const char* result = final ? vosk_recognizer_result(stream->recognizer) : nullptr;
+    stream->metrics.decodeNs += elapsedNs(begin);
+    if (final) {
+        finishUtterance(stream, result);
+    }
+}
+
+void StreamEngine::finishUtterance(Stream* stream, const char* json_result)
+{
+    std::string text = resultText(json_result);
+    if (text.empty()) return;
+
+    ++stream->metrics.utterances;
+    emit logMessage(QString("[%1] Распознано: %2")
+                    .arg(QString::fromStdString(stream->config.name), QString::fromStdString(text)));
+    // Команда выполняется в задаче этого потока: медленный скрипт задерживает только его
+    if (dispatcher && dispatcher(stream->config.name, json_result)) {
+        ++stream->metrics.commands;
+    }
+}
+
+void StreamEngine::logMetrics()
+{
+    for (const auto& stream : streams) {
+        const StreamMetrics& m = stream->metrics;
+        double audioSeconds = static_cast<double>(m.audioSamples) / STREAM_SAMPLE_RATE;
+        double rtf = audioSeconds > 0.0 ? m.decodeNs / 1e9 / audioSeconds : 0.0;
+        double cpuPercent = audioSeconds > 0.0 ? 100.0 * m.cpuNs / 1e9 / audioSeconds : 0.0;
+        uint64_t dropped = stream->capture ? stream->capture->stats().framesDropped * stream->capture->frameSamples()
+                                           : stream->droppedSamples.load();
+        emit logMessage(QString("Поток %1: аудио %2 с, фраз %3, команд %4, RTF распознавателя %5, CPU %6%, потеряно отсчётов %7")
+                        .arg(QString::fromStdString(stream->config.name))
+                        .arg(audioSeconds, 0, 'f', 1)
+                        .arg(static_cast<qint64>(m.utterances))
+                        .arg(static_cast<qint64>(m.commands))
+                        .arg(rtf, 0, 'f', 3)
+                        .arg(cpuPercent, 0, 'f', 2)
+                        .arg(static_cast<qint64>(dropped)));
+    }
+    if (pool) {
+        emit logMessage(QString("Пул потоков распознавания: задач %1, перехвачено %2")
+                        .arg(static_cast<qint64>(pool->executedTasks()))
+                        .arg(static_cast<qint64>(pool->stolenTasks())));
+    }
+}
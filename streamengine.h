@@ -0,0 +1,102 @@
+#ifndef STREAMENGINE_H
+#define STREAMENGINE_H
+
+#include <QObject>
+#include "vosk_api.h"
+#include "audiocapture.h"
+#include "vad.h"
+#include "threadpool.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Источник звука дополнительного потока
+enum class StreamSourceType {
+    Alsa,       // Устройство ALSA
+    Socket      // Локальный сокет: клиент пишет 16 кГц моно s16le
+};
+
+struct StreamConfig {
+    std::string name;
+    StreamSourceType type = StreamSourceType::Alsa;
+    std::string address;                // Имя устройства ALSA или путь к сокету
+};
+
+// Общие параметры всех потоков
+struct StreamEngineOptions {
+    unsigned int threads = 0;           // Потоков пула (0 — по числу ядер)
+    std::string grammar;                // Грамматика распознавателей (пусто — свободная речь)
+    bool vadEnabled = true;
+    VadOptions vad;
+    unsigned int preRollMs = 300;
+    CaptureOptions capture;             // Шаблон параметров захвата для ALSA источников
+};
+
+// Счётчики потока
+struct StreamMetrics {
+    uint64_t audioSamples = 0;          // 16 кГц, после ресемплинга
+    uint64_t utterances = 0;
+    uint64_t commands = 0;
+    uint64_t decodeNs = 0;              // Время внутри распознавателя
+    uint64_t cpuNs = 0;                 // CPU потоков пула на обработку этого потока
+    uint64_t droppedSamples = 0;        // Звук из сокета, не поместившийся в буфер
+};
+
+// Обработчик распознанной фразы: имя потока и финальный результат Vosk (JSON со словами и conf),
+// возвращает true, если выполнена команда. Вызывается из потока пула; фразы одного потока приходят по очереди.
+typedef std::function<bool(const std::string& stream, const char* json_result)> StreamDispatcher;
+
+// Несколько одновременных потоков распознавания на одной модели.
+// У каждого потока свой источник, ресемплер, детектор речи и VoskRecognizer; модель общая,
+// поэтому память растёт только на состояние распознавателя. Обработка идёт задачами
+// в пуле с перехватом работы, одновременно не больше одной задачи на поток.
+class StreamEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StreamEngine(QObject *parent = nullptr);
+    ~StreamEngine();
+
+    // Разбирает описание источника вида "alsa:<устройство>" или "unix:<путь к сокету>"
+    static bool parseSource(const std::string& name, const std::string& spec, StreamConfig& config);
+
+    // false — не запущен ни один поток (причины выводятся в лог)
+    bool start(VoskModel* model, const std::vector<StreamConfig>& configs,
+               const StreamEngineOptions& options, StreamDispatcher dispatcher);
+    // Новая грамматика для потоков, запущенных с грамматикой; применяется в задаче потока перед следующим звуком
+    void setGrammar(const std::string& grammar);
+    // Останавливает источники, дожидается обработки и выводит метрики в лог
+    void stop();
+    bool isRunning() const { return running; }
+    size_t streamCount() const { return streams.size(); }
+
+signals:
+    void logMessage(const QString& message);
+
+private:
+    struct Stream;
+
+    bool openSource(Stream* stream);
+    void closeSource(Stream* stream);
+    void socketLoop(Stream* stream);
+    void schedule(Stream* stream);
+    void pump(Stream* stream);
+    void drain(Stream* stream);
+    void feed(Stream* stream, const short* samples, size_t count);
+    void accept(Stream* stream, const short* samples, size_t count);
+    void finishUtterance(Stream* stream, const char* json_result);
+    void logMetrics();
+
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::unique_ptr<WorkStealingPool> pool;
+    StreamEngineOptions options;
+    StreamDispatcher dispatcher;
+    int stopFd;                         // eventfd остановки потоков чтения сокетов
+    bool running;
+};
+
+#endif // STREAMENGINE_H
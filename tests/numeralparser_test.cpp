@@ -0,0 +1,89 @@
+// Проверки разбора числительных: ctest в каталоге сборки или ./numeralparser-test
+#include "numeralparser.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+// Ожидается, что разобрано ровно expectedText (начало text) и получено expected
+void checkNumber(const std::string& text, const std::string& expectedText, int64_t expected)
+{
+    int64_t value = -1;
+    size_t length = NumeralParser::parseNumber(text, value);
+    if (length != expectedText.size() || (length > 0 && value != expected)) {
+        std::printf("FAIL parseNumber(\"%s\"): длина %zu, значение %lld; ожидалось \"%s\" = %lld\n",
+                    text.c_str(), length, static_cast<long long>(value), expectedText.c_str(),
+                    static_cast<long long>(expected));
+        ++failures;
+    }
+}
+
+// Длительность не должна разбираться
+void checkNoDuration(const std::string& text)
+{
+    int64_t seconds = -1;
+    size_t length = NumeralParser::parseDuration(text, seconds);
+    if (length != 0) {
+        std::printf("FAIL parseDuration(\"%s\"): длина %zu, секунд %lld; ожидался отказ\n",
+                    text.c_str(), length, static_cast<long long>(seconds));
+        ++failures;
+    }
+}
+
+void checkDuration(const std::string& text, int64_t expected)
+{
+    int64_t seconds = -1;
+    size_t length = NumeralParser::parseDuration(text, seconds);
+    if (length != text.size() || seconds != expected) {
+        std::printf("FAIL parseDuration(\"%s\"): длина %zu, секунд %lld; ожидалось %lld\n",
+                    text.c_str(), length, static_cast<long long>(seconds), static_cast<long long>(expected));
+        ++failures;
+    }
+}
+
+} // namespace
+
+int main()
+{
+    checkNumber("сто двадцать пять", "сто двадцать пять", 125);
+    checkNumber("две тысячи сорок", "две тысячи сорок", 2040);
+    checkNumber("тысяча", "тысяча", 1000);
+    checkNumber("три миллиона двести тысяч", "три миллиона двести тысяч", 3200000);
+    checkNumber("42 градуса", "42", 42);
+    checkNumber("5 тысяч", "5 тысяч", 5000);
+    checkNumber("двадцать двадцать", "двадцать", 20);
+    checkNumber("пятнадцать три", "пятнадцать", 15);
+    checkNumber("тысяча миллионов", "тысяча", 1000);
+    checkNumber("громкость", "", 0);
+
+    // Ноль не умножается: "ноль тысяч" — это ноль, а не тысяча
+    checkNumber("ноль", "ноль", 0);
+    checkNumber("ноль тысяч", "ноль", 0);
+    checkNumber("0 тысяч", "0", 0);
+    checkNumber("ноль пять", "ноль", 0);
+
+    // Переполнение int64_t: больше 12 цифр — не число, 12 цифр с миллионом ещё помещаются
+    checkNumber("999999999999 миллионов", "999999999999 миллионов", 999999999999000000LL);
+    checkNumber("999999999999 миллионов 999999999999 тысяч 999999999999",
+                "999999999999 миллионов 999999999999 тысяч 999999999999",
+                999999999999000000LL + 999999999999000LL + 999999999999LL);
+    checkNumber("9999999999999 миллионов", "", 0);
+    checkNumber("1000000000000000", "", 0);
+
+    checkDuration("пять минут", 300);
+    checkDuration("полтора часа", 5400);
+    checkDuration("полчаса", 1800);
+    checkDuration("час тридцать минут", 5400);
+    checkDuration("две минуты и десять секунд", 130);
+    checkDuration("час с половиной", 5400);
+    checkDuration("сто дней", 8640000);
+
+    // Переполнение при умножении на единицу времени: такая длительность отклоняется
+    checkNoDuration("999999999999 миллионов дней");
+    checkNoDuration("миллион дней");
+
+    if (failures == 0) std::printf("OK\n");
+    return failures == 0 ? 0 : 1;
+}
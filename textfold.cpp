@@ -0,0 +1,179 @@
+#include "textfold.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Кириллица в UTF-8 — двухбайтовые последовательности с ведущим байтом D0 или D1:
+//   А-П  D0 90-9F → а-п  D0 B0-BF
+//   Р-Я  D0 A0-AF → р-я  D1 80-8F
+//   Ѐ-Џ  D0 80-8F → ѐ-џ  D1 90-9F (кроме Ё)
+//   Ё D0 81, ё D1 91 → е D0 B5
+#define LEAD_0 0xD0
+#define LEAD_1 0xD1
+#define IE_TRAIL 0xB5
+
+namespace {
+
+inline bool isSpace(unsigned char c)
+{
+    return c <= 0x20;
+}
+
+// Один символ с позиции p: пишет свёрнутые байты в out, возвращает число прочитанных байт
+inline size_t foldUnit(const unsigned char* p, const unsigned char* end, char* out, size_t& length)
+{
+    unsigned char c = *p;
+    if (isSpace(c)) {
+        if (length > 0 && out[length - 1] != ' ') {
+            out[length++] = ' ';
+        }
+        return 1;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        out[length++] = static_cast<char>(c + 0x20);
+        return 1;
+    }
+    if ((c == LEAD_0 || c == LEAD_1) && p + 1 < end && (p[1] & 0xC0) == 0x80) {
+        unsigned char lead = c;
+        unsigned char trail = p[1];
+        if ((lead == LEAD_0 && trail == 0x81) || (lead == LEAD_1 && trail == 0x91)) {
+            lead = LEAD_0;
+            trail = IE_TRAIL;
+        } else if (lead == LEAD_0 && trail >= 0x80 && trail <= 0x8F) {
+            lead = LEAD_1;
+            trail += 0x10;
+        } else if (lead == LEAD_0 && trail >= 0x90 && trail <= 0x9F) {
+            trail += 0x20;
+        } else if (lead == LEAD_0 && trail >= 0xA0 && trail <= 0xAF) {
+            lead = LEAD_1;
+            trail -= 0x20;
+        }
+        out[length++] = static_cast<char>(lead);
+        out[length++] = static_cast<char>(trail);
+        return 2;
+    }
+    out[length++] = static_cast<char>(c);
+    return 1;
+}
+
+inline size_t trimEnd(char* out, size_t length)
+{
+    return (length > 0 && out[length - 1] == ' ') ? length - 1 : length;
+}
+
+#if defined(__SSE2__)
+// Байты v из диапазона [lo, hi] (беззнаково)
+inline __m128i inRange(__m128i v, unsigned char lo, unsigned char hi)
+{
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(lo)));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(static_cast<char>(hi - lo))), shifted);
+}
+
+inline __m128i equals(__m128i v, unsigned char c)
+{
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(c)));
+}
+
+inline __m128i delta(__m128i mask, unsigned char value)
+{
+    return _mm_and_si128(mask, _mm_set1_epi8(static_cast<char>(value)));
+}
+
+// Блок из 16 байт с позиции p. Каждый байт меняется по своему значению и соседям из исходного текста
+// (prev — для второго байта кириллицы, next — для ведущего), поэтому пара на границе блоков
+// сворачивается согласованно. Возвращает false, если в блоке есть пробелы, которые нужно схлопнуть, —
+// такой блок проходит побайтово.
+inline bool foldBlock(const unsigned char* p, char* out)
+{
+    __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p - 1));
+    __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+
+    __m128i control = inRange(cur, 0x00, 0x1F);
+    __m128i repeatedSpace = _mm_and_si128(equals(cur, ' '), inRange(prev, 0x00, 0x20));
+    if (_mm_movemask_epi8(_mm_or_si128(control, repeatedSpace))) {
+        return false;
+    }
+
+    __m128i prevLead0 = equals(prev, LEAD_0);
+    __m128i prevLead1 = equals(prev, LEAD_1);
+    __m128i curLead0 = equals(cur, LEAD_0);
+    __m128i curLead1 = equals(cur, LEAD_1);
+
+    __m128i upperIo = _mm_and_si128(prevLead0, equals(cur, 0x81));
+    __m128i lowerIo = _mm_and_si128(prevLead1, equals(cur, 0x91));
+    __m128i extended = _mm_andnot_si128(upperIo, _mm_and_si128(prevLead0, inRange(cur, 0x80, 0x8F)));
+    __m128i firstHalf = _mm_and_si128(prevLead0, inRange(cur, 0x90, 0x9F));
+    __m128i secondHalf = _mm_and_si128(prevLead0, inRange(cur, 0xA0, 0xAF));
+
+    __m128i toLead1 = _mm_and_si128(curLead0, _mm_or_si128(_mm_andnot_si128(equals(next, 0x81), inRange(next, 0x80, 0x8F)),
+                                                            inRange(next, 0xA0, 0xAF)));
+    __m128i toLead0 = _mm_and_si128(curLead1, equals(next, 0x91));
+
+    // Маски не пересекаются, поэтому сдвиги складываются в один вектор
+    __m128i shift = _mm_or_si128(
+        _mm_or_si128(delta(inRange(cur, 'A', 'Z'), 0x20), delta(firstHalf, 0x20)),
+        _mm_or_si128(_mm_or_si128(delta(secondHalf, 0xE0), delta(extended, 0x10)),
+                     _mm_or_si128(_mm_or_si128(delta(upperIo, IE_TRAIL - 0x81), delta(lowerIo, IE_TRAIL - 0x91)),
+                                  _mm_or_si128(delta(toLead1, 0x01), delta(toLead0, 0xFF)))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi8(cur, shift));
+    return true;
+}
+#endif
+
+} // namespace
+
+size_t foldTextScalar(const char* text, size_t size, char* out)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    const unsigned char* end = p + size;
+    size_t length = 0;
+    while (p < end) {
+        p += foldUnit(p, end, out, length);
+    }
+    return trimEnd(out, length);
+}
+
+size_t foldText(const char* text, size_t size, char* out)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    const unsigned char* end = p + size;
+    size_t length = 0;
+
+#if defined(__SSE2__)
+    // Блоку нужен байт до и байт после; первый символ всегда проходит побайтово
+    if (p < end) {
+        p += foldUnit(p, end, out, length);
+    }
+    while (end - p > 16) {
+        if (!foldBlock(p, out + length)) {
+            p += foldUnit(p, end, out, length);
+            continue;
+        }
+        // Ведущий байт кириллицы в конце блока уже свёрнут по следующему байту,
+        // а сам следующий байт должен войти в блок вместе с ним
+        size_t taken = (p[15] >= 0xC0) ? 15 : 16;
+        p += taken;
+        length += taken;
+    }
+#endif
+    while (p < end) {
+        p += foldUnit(p, end, out, length);
+    }
+    return trimEnd(out, length);
+}
+
+std::string_view foldText(std::string_view text, std::string& buffer)
+{
+    if (buffer.size() < text.size()) {
+        buffer.resize(text.size());
+    }
+    return std::string_view(buffer.data(), foldText(text.data(), text.size(), &buffer[0]));
+}
+
+std::string foldedText(std::string_view text)
+{
+    std::string result(text.size(), '\0');
+    result.resize(foldText(text.data(), text.size(), &result[0]));
+    return result;
+}
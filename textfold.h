@@ -0,0 +1,22 @@
+#ifndef TEXTFOLD_H
+#define TEXTFOLD_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Приведение UTF-8 текста к виду для сравнения ключевых слов:
+// нижний регистр для ASCII и кириллицы, ё → е, любые пробельные и управляющие символы
+// схлопываются в один пробел, пробелы по краям отбрасываются.
+// Результат никогда не длиннее исходного текста, поэтому out должен вмещать size байт.
+size_t foldText(const char* text, size_t size, char* out);
+
+// Побайтовый вариант без SIMD — эталон для проверки и бенчмарков
+size_t foldTextScalar(const char* text, size_t size, char* out);
+
+// Свёртка в переиспользуемый буфер: после первых вызовов память не выделяется
+std::string_view foldText(std::string_view text, std::string& buffer);
+
+std::string foldedText(std::string_view text);
+
+#endif // TEXTFOLD_H
@@ -0,0 +1,115 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace {
+// Пул и номер очереди текущего потока (nullptr — поток не из пула)
+thread_local WorkStealingPool* currentPool = nullptr;
+thread_local unsigned int currentIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int threads)
+    : pending(0)
+    , stopping(false)
+    , nextQueue(0)
+    , executed(0)
+    , stolen(0)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 0; i < threads; ++i) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    shutdown();
+}
+
+void WorkStealingPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    unsigned int index = (currentPool == this)
+                             ? currentIndex
+                             : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+bool WorkStealingPool::take(unsigned int index, Task& task)
+{
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Своя очередь пуста — перехватываем у соседей, начиная со следующего
+    for (size_t step = 1; step < queues.size(); ++step) {
+        Queue& other = *queues[(index + step) % queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned int index)
+{
+    currentPool = this;
+    currentIndex = index;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]() { return pending > 0 || stopping; });
+            if (pending == 0) {
+                // Остановка, и все задачи выполнены
+                return;
+            }
+            --pending;
+        }
+
+        // Задача кладётся в очередь до увеличения счётчика, поэтому зарезервированная
+        // задача уже лежит в одной из очередей; обход может разминуться с ней лишь на миг
+        Task task;
+        while (!take(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+        executed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
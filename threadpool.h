@@ -0,0 +1,60 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing).
+// У каждого потока своя очередь: свои задачи он берёт с конца (свежие данные ещё в кэше),
+// а простаивающий поток забирает самые старые задачи из начала чужих очередей.
+// Задача, поставленная из потока пула, попадает в его собственную очередь.
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    // threads = 0 — по числу ядер
+    explicit WorkStealingPool(unsigned int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+    // Выполняет оставшиеся задачи и останавливает потоки; счётчики остаются доступны
+    void shutdown();
+
+    unsigned int threadCount() const { return static_cast<unsigned int>(workers.size()); }
+    uint64_t executedTasks() const { return executed.load(std::memory_order_relaxed); }
+    uint64_t stolenTasks() const { return stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned int index);
+    bool take(unsigned int index, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    size_t pending;                     // Поставленные, но ещё не взятые задачи (под sleepMutex)
+    bool stopping;
+
+    std::atomic<unsigned int> nextQueue;
+    std::atomic<uint64_t> executed;
+    std::atomic<uint64_t> stolen;
+};
+
+#endif // THREADPOOL_H
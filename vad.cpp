@@ -0,0 +1,188 @@
+#include "vad.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Уровень шума догоняет тихие кадры быстро, а громкие — медленно
+const float NOISE_FALL = 0.2f;
+const float NOISE_RISE = 0.002f;
+// Кадры громче этого порога ZCR похожи на шипение, а не на голос
+const float MAX_SPEECH_ZCR = 0.6f;
+
+float toDb(uint64_t sumSquares, size_t count)
+{
+    double mean = static_cast<double>(sumSquares) / std::max<size_t>(count, 1);
+    return static_cast<float>(10.0 * std::log10(mean + 1.0));
+}
+
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector(const VadOptions& opts)
+{
+    configure(opts);
+}
+
+void VoiceActivityDetector::configure(const VadOptions& opts)
+{
+    options = opts;
+    onsetSamples = static_cast<size_t>(options.sampleRate) * options.onsetMs / 1000;
+    hangoverSamples = static_cast<size_t>(options.sampleRate) * options.hangoverMs / 1000;
+    reset();
+}
+
+void VoiceActivityDetector::reset()
+{
+    active = false;
+    primed = false;
+    noiseDb = 0.0f;
+    previousEnergyDb = 0.0f;
+    previousHighDb = 0.0f;
+    speechRun = 0;
+    silenceRun = 0;
+    samplesTotal = 0;
+    samplesGated = 0;
+    segments = 0;
+}
+
+// Отсчёты делятся на 4 до возведения в квадрат: абсолютный уровень не важен, а так
+// суммы пар в _mm_madd_epi16 и разности соседних отсчётов не переполняются.
+VoiceActivityDetector::Features VoiceActivityDetector::analyze(const short* x, size_t count)
+{
+    uint64_t energy = 0;
+    uint64_t highBand = 0;
+    size_t crossings = 0;
+    size_t i = 1;
+
+    if (count > 0) {
+        int s = x[0] >> 2;
+        energy += static_cast<uint64_t>(s * s);
+    }
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i accEnergy = _mm_setzero_si128();
+    __m128i accHigh = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i rawPrev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 1));
+        __m128i v = _mm_srai_epi16(raw, 2);
+        __m128i d = _mm_sub_epi16(v, _mm_srai_epi16(rawPrev, 2));
+
+        __m128i e = _mm_madd_epi16(v, v);
+        __m128i h = _mm_madd_epi16(d, d);
+        accEnergy = _mm_add_epi64(accEnergy, _mm_add_epi64(_mm_unpacklo_epi32(e, zero), _mm_unpackhi_epi32(e, zero)));
+        accHigh = _mm_add_epi64(accHigh, _mm_add_epi64(_mm_unpacklo_epi32(h, zero), _mm_unpackhi_epi32(h, zero)));
+
+        // Переход через ноль — у соседних отсчётов разные знаки
+        __m128i signChange = _mm_cmplt_epi16(_mm_xor_si128(raw, rawPrev), zero);
+        crossings += static_cast<size_t>(__builtin_popcount(_mm_movemask_epi8(signChange))) / 2;
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), accEnergy);
+    energy += lanes[0] + lanes[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), accHigh);
+    highBand += lanes[0] + lanes[1];
+#elif defined(__ARM_NEON)
+    int64x2_t accEnergy = vdupq_n_s64(0);
+    int64x2_t accHigh = vdupq_n_s64(0);
+    uint16x8_t accCross = vdupq_n_u16(0);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t raw = vld1q_s16(x + i);
+        int16x8_t rawPrev = vld1q_s16(x + i - 1);
+        int16x8_t v = vshrq_n_s16(raw, 2);
+        int16x8_t d = vsubq_s16(v, vshrq_n_s16(rawPrev, 2));
+
+        int32x4_t e = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+        e = vmlal_s16(e, vget_high_s16(v), vget_high_s16(v));
+        int32x4_t h = vmull_s16(vget_low_s16(d), vget_low_s16(d));
+        h = vmlal_s16(h, vget_high_s16(d), vget_high_s16(d));
+        accEnergy = vpadalq_s32(accEnergy, e);
+        accHigh = vpadalq_s32(accHigh, h);
+
+        uint16x8_t signChange = vcltq_s16(veorq_s16(raw, rawPrev), vdupq_n_s16(0));
+        accCross = vsubq_u16(accCross, signChange);
+    }
+    energy += static_cast<uint64_t>(vgetq_lane_s64(accEnergy, 0) + vgetq_lane_s64(accEnergy, 1));
+    highBand += static_cast<uint64_t>(vgetq_lane_s64(accHigh, 0) + vgetq_lane_s64(accHigh, 1));
+    uint32x4_t crossWide = vpaddlq_u16(accCross);
+    crossings += vgetq_lane_u32(crossWide, 0) + vgetq_lane_u32(crossWide, 1)
+               + vgetq_lane_u32(crossWide, 2) + vgetq_lane_u32(crossWide, 3);
+#endif
+
+    for (; i < count; ++i) {
+        int v = x[i] >> 2;
+        int d = v - (x[i - 1] >> 2);
+        energy += static_cast<uint64_t>(v * v);
+        highBand += static_cast<uint64_t>(d * d);
+        if ((x[i] ^ x[i - 1]) < 0) {
+            ++crossings;
+        }
+    }
+
+    Features f;
+    f.energyDb = toDb(energy, count);
+    f.highBandDb = toDb(highBand, count);
+    f.zeroCrossingRate = count > 1 ? static_cast<float>(crossings) / (count - 1) : 0.0f;
+    return f;
+}
+
+VoiceActivityDetector::Decision VoiceActivityDetector::process(const short* samples, size_t count)
+{
+    Features f = analyze(samples, count);
+    samplesTotal += count;
+
+    if (!primed) {
+        // Первый кадр задаёт начальный уровень шума
+        noiseDb = f.energyDb;
+        previousEnergyDb = f.energyDb;
+        previousHighDb = f.highBandDb;
+        primed = true;
+    }
+
+    // Спектральный поток по двум полосам: положительный прирост энергии
+    float flux = std::max(0.0f, f.energyDb - previousEnergyDb) + std::max(0.0f, f.highBandDb - previousHighDb);
+    previousEnergyDb = f.energyDb;
+    previousHighDb = f.highBandDb;
+
+    bool loud = f.energyDb > noiseDb + options.thresholdDb;
+    bool voiced = loud && (f.zeroCrossingRate < MAX_SPEECH_ZCR || flux > options.fluxThresholdDb);
+
+    // Уровень шума обновляется только на кадрах без речи
+    if (!voiced) {
+        float rate = f.energyDb < noiseDb ? NOISE_FALL : NOISE_RISE;
+        noiseDb += (f.energyDb - noiseDb) * rate;
+    }
+
+    if (!active) {
+        speechRun = voiced ? speechRun + count : 0;
+        // Резкий рост энергии открывает шлюз сразу, ровный шум — только после onsetMs
+        if (voiced && (speechRun >= onsetSamples || flux > options.fluxThresholdDb)) {
+            active = true;
+            silenceRun = 0;
+            ++segments;
+            return Speech;
+        }
+        samplesGated += count;
+        return Silence;
+    }
+
+    if (voiced) {
+        silenceRun = 0;
+        return Speech;
+    }
+
+    silenceRun += count;
+    if (silenceRun >= hangoverSamples) {
+        active = false;
+        speechRun = 0;
+        return SpeechEnd;
+    }
+    return Speech;
+}
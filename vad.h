@@ -0,0 +1,68 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Параметры детектора речи
+struct VadOptions {
+    unsigned int sampleRate = 16000;
+    float thresholdDb = 9.0f;       // Превышение энергии над уровнем шума, при котором кадр считается речью
+    float fluxThresholdDb = 6.0f;   // Рост энергии между кадрами, достаточный для начала речи
+    unsigned int onsetMs = 40;      // Сколько речи подряд нужно, чтобы открыть шлюз
+    unsigned int hangoverMs = 400;  // Сколько тишины после речи держать шлюз открытым
+};
+
+// Детектор речевой активности по энергии, числу переходов через ноль и спектральному потоку
+// (рост энергии в низкой и высокой полосе между кадрами). Признаки кадра считаются векторно (SSE2/NEON).
+class VoiceActivityDetector
+{
+public:
+    enum Decision {
+        Silence,        // Шлюз закрыт, кадр можно не отдавать распознавателю
+        Speech,         // Шлюз открыт
+        SpeechEnd       // Речь закончилась на этом кадре (истекло удержание) — пора завершить фразу
+    };
+
+    explicit VoiceActivityDetector(const VadOptions& options = VadOptions());
+
+    void configure(const VadOptions& options);
+    void reset();
+
+    // Один вызов — один кадр (обычно 10–30 мс)
+    Decision process(const short* samples, size_t count);
+
+    bool inSpeech() const { return active; }
+
+    // Счётчики в отсчётах
+    uint64_t totalSamples() const { return samplesTotal; }
+    uint64_t gatedSamples() const { return samplesGated; }
+    uint64_t speechSegments() const { return segments; }
+    double gatedFraction() const { return samplesTotal ? static_cast<double>(samplesGated) / samplesTotal : 0.0; }
+
+private:
+    struct Features {
+        float energyDb;
+        float highBandDb;
+        float zeroCrossingRate;
+    };
+
+    static Features analyze(const short* samples, size_t count);
+
+    VadOptions options;
+    bool active;
+    bool primed;
+    float noiseDb;
+    float previousEnergyDb;
+    float previousHighDb;
+    size_t speechRun;       // Отсчёты речи подряд до открытия шлюза
+    size_t silenceRun;      // Отсчёты тишины подряд во время речи
+    size_t onsetSamples;
+    size_t hangoverSamples;
+
+    uint64_t samplesTotal;
+    uint64_t samplesGated;
+    uint64_t segments;
+};
+
+#endif // VAD_H
@@ -1,4 +1,9 @@
 #include "voiceassistant.h"
+#include "modelcache.h"
+#include "modelprewarm.h"
+#include "resultparser.h"
+#include "textfold.h"
+#include "numeralparser.h"
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
@@ -7,15 +12,25 @@
 #include <QCoreApplication> // Для QCoreApplication::applicationDirPath()
 #include <QFileInfo>       // Для QFileInfo::exists()
 #include <QDebug>          // Для qDebug(), qWarning()
+#include <QSettings>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
 #include <fstream>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <algorithm>
 #include <sstream>
+#include <cstdlib>
 #include <iostream>
+#include <chrono>
+#include <thread>
+#include <time.h>
 
 #define SAMPLE_RATE 16000
-#define BUFFER_SIZE 8000
+#define VAD_FRAME (SAMPLE_RATE / 50)   // 20 мс
+#define WAKE_HISTORY (SAMPLE_RATE * 2) // 2 с звука до срабатывания фразы активации
 
 // --- Добавленная функция для поиска модели ---
 std::string findModelPath() {
@@ -55,188 +70,1122 @@ std::string findModelPath() {
 }
 // --- ---
 
+// Процессорное время вызывающего потока
+static uint64_t threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Свёрнутый для сравнения текст в буфере вызывающего потока: без выделения памяти на каждую фразу.
+// Действителен до следующего вызова в том же потоке.
+static std::string_view foldForMatch(const std::string& text)
+{
+    static thread_local std::string buffer;
+    return foldText(text, buffer);
+}
+
+// Параметры команды из текста за совпавшими словами. Шаблоны с параметрами пробуются раньше
+// простых ключевых слов; false — ни один шаблон с этим началом не подошёл
+static bool resolveSlots(const CommandInfo& cmd, std::string_view folded, const CommandHit& hit,
+                         std::vector<SlotValue>* values)
+{
+    std::vector<SlotValue> none;
+    for (int pass = 0; pass < 2; ++pass) {
+        bool withSlots = pass == 0;
+        // Частичный результат: параметры могли ещё не прозвучать
+        if (withSlots && !values) continue;
+        for (const auto& pattern : cmd.patterns) {
+            if (pattern.hasSlots() != withSlots) continue;
+            bool sameHead = hit.fuzzy ? pattern.headWords() == hit.wordCount
+                                      : folded.substr(hit.start, hit.length) == pattern.head();
+            if (sameHead && pattern.extract(folded, hit.end, values ? *values : none)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 VoiceAssistantWorker::VoiceAssistantWorker(QObject *parent)
     : QObject(parent)
     , running(false)
+    , loading(false)
+    , loadGeneration(0)
+    , activeLoaders(0)
     , model(nullptr)
     , recognizer(nullptr)
-    , processTimer(new QTimer(this))
+    , fuzzyEnabled(true)
+    , fuzzyThreshold(0.3)
+    , commandScorer(commandMatcher, fuzzyMatcher)
+    , maxAlternatives(3)
+    , minCommandScore(0.5)
+    , multiCommand(true)
+    , capture(new AudioCapture(this))
+    , maxChunkFrames(0)
+    , resampleNs(0)
+    , resampleInputFrames(0)
+    , vadEnabled(true)
+    , grammarMode(false)
+    , commandsWatcher(new QFileSystemWatcher(this))
+    , reloadTimer(new QTimer(this))
+    , streamEngine(new StreamEngine(this))
+    , executor(new ProcessExecutor(this))
+    , killOnStop(true)
+    , plugins(new PluginHost(this))
+    , earlyDispatch(false)
+    , stablePartials(2)
+    , partialStreak(0)
+    , utteranceActive(false)
+    , cascadeEnabled(false)
+    , cascadeActive(false)
+    , wakeRecognizer(nullptr)
+    , cascadeTimeoutMs(5000)
+    , cascadeTriggers(0)
+    , stageCpuNs{0, 0}
+    , stageWallNs{0, 0}
+    , stageCpuMark(0)
+    , fanoutTimeoutMs(1000)
+    , fanoutFirstCore(-1)
+    , fanoutMaxQueueMs(2000)
+    , fanoutUtterance(0)
+    , fanoutPending(false)
+    , fanoutTimer(new QTimer(this))
 {
-    connect(processTimer, &QTimer::timeout, this, &VoiceAssistantWorker::run);
+    connect(capture, &AudioCapture::logMessage, this, &VoiceAssistantWorker::logMessage);
+    connect(streamEngine, &StreamEngine::logMessage, this, &VoiceAssistantWorker::logMessage);
+    connect(executor, &ProcessExecutor::logMessage, this, &VoiceAssistantWorker::logMessage);
+    connect(plugins, &PluginHost::logMessage, this, &VoiceAssistantWorker::logMessage);
+    // Редакторы сохраняют файл в несколько приёмов — перечитываем команды один раз после паузы
+    reloadTimer->setSingleShot(true);
+    reloadTimer->setInterval(500);
+    connect(reloadTimer, &QTimer::timeout, this, &VoiceAssistantWorker::reloadCommands);
+    fanoutTimer->setSingleShot(true);
+    connect(fanoutTimer, &QTimer::timeout, this, &VoiceAssistantWorker::decideFanout);
+    connect(commandsWatcher, &QFileSystemWatcher::directoryChanged, this, &VoiceAssistantWorker::onCommandsChanged);
+    connect(commandsWatcher, &QFileSystemWatcher::fileChanged, this, &VoiceAssistantWorker::onCommandsChanged);
+    // Поток захвата сообщает о новых кадрах, разбор идёт в потоке распознавания
+    connect(capture, &AudioCapture::framesAvailable, this, &VoiceAssistantWorker::processAudio, Qt::QueuedConnection);
+    connect(capture, &AudioCapture::captureFailed, this, &VoiceAssistantWorker::onCaptureFailed, Qt::QueuedConnection);
 }
 
 VoiceAssistantWorker::~VoiceAssistantWorker()
 {
     stop();
+    // Обратные вызовы исполнителя и модулей обращаются к this и ставят друг другу следующие команды:
+    // сначала пул модулей перестаёт принимать вызовы, затем удаляется исполнитель, и только потом пул
+    plugins->shutdown();
+    delete executor;
+    executor = nullptr;
+    delete plugins;
+    plugins = nullptr;
+
+    // Фоновая загрузка обращается к this — дожидаемся её завершения
+    std::unique_lock<std::mutex> lock(loaderMutex);
+    loaderDone.wait(lock, [this]() { return activeLoaders == 0; });
 }
 
 void VoiceAssistantWorker::start()
 {
-    if (running) return;
-    
+    if (running || loading) return;
+
+    loading = true;
+    const uint64_t generation = ++loadGeneration;
+    startClock = std::chrono::steady_clock::now();
+    timings = StartupTimings();
+    emit statusChanged(false);
     emit logMessage("Поиск и загрузка модели Vosk...");
-    
-    // Используем новую функцию для поиска модели
-    std::string modelPath = findModelPath();
-    if (modelPath.empty()) {
+
+    QSettings settings("VoiceAssistant", "GUI");
+    // Модель берётся из общего кэша: после остановки она остаётся в памяти
+    ModelCache::instance().configure(settings.value("model/keepResident", true).toBool(),
+                                     std::chrono::seconds(settings.value("model/idleTimeoutSec", 300).toInt()));
+
+    // [fanout]: имя=model:<каталог модели> или имя=grammar
+    fanoutConfigs.clear();
+    settings.beginGroup("fanout");
+    for (const QString& key : settings.childKeys()) {
+        if (key == "timeoutMs" || key == "firstCore" || key == "maxQueueMs") continue;
+        QString spec = settings.value(key).toString();
+        FanoutBranchConfig config;
+        config.name = key.toStdString();
+        if (spec == "grammar") {
+            config.grammar = true;
+        } else if (spec.startsWith("model:")) {
+            config.modelPath = spec.mid(6).toStdString();
+        } else {
+            emit logMessage(QString("Неверное описание ветви %1: %2").arg(key, spec));
+            continue;
+        }
+        fanoutConfigs.push_back(config);
+    }
+    fanoutTimeoutMs = settings.value("timeoutMs", 1000).toInt();
+    fanoutFirstCore = settings.value("firstCore", -1).toInt();
+    fanoutMaxQueueMs = static_cast<unsigned int>(std::max(100, settings.value("maxQueueMs", 2000).toInt()));
+    settings.endGroup();
+
+    // Поиск и загрузка модели идут в фоновом потоке, поток ассистента остаётся свободным
+    // (в том числе для stop(), который отменяет загрузку)
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        ++activeLoaders;
+    }
+    std::thread([this, generation, branchConfigs = fanoutConfigs]() {
+        ModelLoadResult result;
+        auto phaseStart = std::chrono::steady_clock::now();
+        result.modelPath = findModelPath();
+        result.pathDiscoveryMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - phaseStart).count();
+
+        if (!result.modelPath.empty()) {
+            phaseStart = std::chrono::steady_clock::now();
+            result.model = ModelCache::instance().acquire(result.modelPath, &result.fromCache);
+            result.modelLoadMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - phaseStart).count();
+        }
+
+        // Модели других языков для параллельных ветвей грузятся тем же потоком
+        if (result.model) {
+            for (const auto& config : branchConfigs) {
+                if (config.modelPath.empty()) continue;
+                result.branchModels.emplace_back(config.name, ModelCache::instance().acquire(config.modelPath));
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, result]() {
+            finishStart(generation, result);
+        }, Qt::QueuedConnection);
+
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        --activeLoaders;
+        loaderDone.notify_all();
+    }).detach();
+}
+
+void VoiceAssistantWorker::finishStart(uint64_t generation, const ModelLoadResult& result)
+{
+    if (generation != loadGeneration || !loading) {
+        // Загрузка была отменена — модель больше не нужна
+        if (result.model) {
+            ModelCache::instance().release(result.model);
+        }
+        for (const auto& branch : result.branchModels) {
+            ModelCache::instance().release(branch.second);
+        }
+        return;
+    }
+    loading = false;
+    branchModels = result.branchModels;
+    timings.pathDiscoveryMs = result.pathDiscoveryMs;
+    timings.modelLoadMs = result.modelLoadMs;
+    timings.modelFromCache = result.fromCache;
+
+    // Прогрев (если был) к этому моменту обычно уже завершён; незавершённый ещё догружает файлы
+    PrewarmStats prewarm = ModelPrewarmer::instance().stats();
+    timings.prewarmed = ModelPrewarmer::instance().isStarted();
+    timings.prewarmMs = prewarm.elapsedMs;
+    timings.prewarmBytes = prewarm.bytes;
+    if (timings.prewarmed && prewarm.finished) {
+        QString prewarmMsg = QString("Прогрев модели: %1 файлов, %2 МБ за %3 мс")
+                             .arg(prewarm.files)
+                             .arg(prewarm.bytes / (1024.0 * 1024.0), 0, 'f', 1)
+                             .arg(prewarm.elapsedMs, 0, 'f', 1);
+        if (prewarm.lockedFiles > 0 || prewarm.lockFailures > 0) {
+            prewarmMsg += QString(", закреплено в памяти %1 файлов (%2 МБ), не удалось %3")
+                          .arg(prewarm.lockedFiles)
+                          .arg(prewarm.lockedBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                          .arg(prewarm.lockFailures);
+        }
+        emit logMessage(prewarmMsg);
+    }
+
+    if (result.modelPath.empty()) {
         QString errorMsg = "Критическая ошибка: модель Vosk не найдена ни в одном из стандартных путей!";
         emit logMessage(errorMsg);
-        // В worker'е лучше не показывать QMessageBox напрямую.
-        // Лучше отправить сигнал в MainWindow.
+        emit modelLoadFailed(errorMsg);
+        emit statusChanged(false);
         return;
     }
 
-    emit logMessage(QString("Загрузка модели Vosk из: %1").arg(QString::fromStdString(modelPath)));
-    
-    // Используем найденный путь
-    model = vosk_model_new(modelPath.c_str());
+    model = result.model;
     if (!model) {
-        QString errorMsg = QString("Ошибка загрузки модели Vosk из пути: %1").arg(QString::fromStdString(modelPath));
+        QString errorMsg = QString("Ошибка загрузки модели Vosk из пути: %1").arg(QString::fromStdString(result.modelPath));
         emit logMessage(errorMsg);
+        emit modelLoadFailed(errorMsg);
+        emit statusChanged(false);
         return;
     }
-    
-    recognizer = vosk_recognizer_new(model, SAMPLE_RATE);
+    emit logMessage(result.fromCache
+                    ? QString("Модель Vosk уже в памяти: %1").arg(QString::fromStdString(result.modelPath))
+                    : QString("Загружена модель Vosk из: %1").arg(QString::fromStdString(result.modelPath)));
+
+    QSettings settings("VoiceAssistant", "GUI");
+
+    // Нечёткий поиск команд строится вместе с точным
+    fuzzyEnabled = settings.value("recognition/fuzzy", true).toBool();
+    fuzzyThreshold = std::min(0.5, std::max(0.0, settings.value("recognition/fuzzyThreshold", 0.3).toDouble()));
+
+    // Загружаем команды (до создания распознавателя — из них строится грамматика)
+    auto phaseStart = std::chrono::steady_clock::now();
+    loadCommands();
+    watchCommands();
+    timings.commandsMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - phaseStart).count();
+
+    phaseStart = std::chrono::steady_clock::now();
+    grammarMode = settings.value("recognition/mode", "dictation").toString() == "commands";
+    std::string grammar;
+    if (grammarMode) {
+        // Распознавание только ключевых слов команд: граф меньше, ложных срабатываний меньше
+        grammar = buildGrammar();
+        recognizer = vosk_recognizer_new_grm(model, SAMPLE_RATE, grammar.c_str());
+        emit logMessage("Режим команд: распознаются только ключевые слова");
+    } else {
+        recognizer = vosk_recognizer_new(model, SAMPLE_RATE);
+    }
+    timings.recognizerMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - phaseStart).count();
     if (!recognizer) {
         emit logMessage("Ошибка создания распознавателя!");
-        vosk_model_free(model);
+        emit modelLoadFailed("Ошибка создания распознавателя");
+        releaseFanout();
+        ModelCache::instance().release(model);
         model = nullptr;
+        emit statusChanged(false);
         return;
     }
-    
-    // Загружаем команды
-    loadCommands();
-    
+
+    // Оценка команд: conf слов и N-best вместо ответа «да/нет» по лучшему тексту
+    maxAlternatives = std::min(static_cast<int>(RecognitionResult::MaxAlternatives),
+                               std::max(0, settings.value("recognition/alternatives", 3).toInt()));
+    minCommandScore = std::min(1.0, std::max(0.0, settings.value("recognition/minScore", 0.5).toDouble()));
+    vosk_recognizer_set_words(recognizer, 1);
+    if (maxAlternatives > 0 && !fanoutConfigs.empty()) {
+        // Ветви сравниваются по среднему conf слов, а в формате N-best его нет
+        maxAlternatives = 0;
+        emit logMessage("N-best отключён: при параллельных распознавателях команды оцениваются по conf слов");
+    }
+    if (maxAlternatives > 0) {
+        vosk_recognizer_set_max_alternatives(recognizer, maxAlternatives);
+    }
+    // Несколько команд в одной фразе: деление по связкам и паузам между словами
+    multiCommand = settings.value("recognition/multiCommand", true).toBool();
+    segmenter.setPause(std::max(0, settings.value("recognition/segmentPauseMs", 500).toInt()) / 1000.0);
+
+    // Скрипты команд запускаются асинхронно: поток распознавания не ждёт их завершения
+    ExecutorOptions executorOptions;
+    executorOptions.maxRunning = static_cast<unsigned int>(std::max(1, settings.value("commands/maxParallel", 4).toInt()));
+    executorOptions.maxQueued = static_cast<size_t>(std::max(0, settings.value("commands/maxQueued", 32).toInt()));
+    executorOptions.defaultTimeoutMs = std::max(0, settings.value("commands/timeoutSec", 0).toInt()) * 1000;
+    executorOptions.killGraceMs = std::max(0, settings.value("commands/killGraceMs", 2000).toInt());
+    executorOptions.warmShells = static_cast<size_t>(std::max(0, settings.value("commands/warmShells", 0).toInt()));
+    executor->configure(executorOptions);
+    killOnStop = settings.value("commands/killOnStop", true).toBool();
+    // Модули выполняются в процессе: по таймауту вызов считается неудачным, а поток пула заменяется
+    PluginOptions pluginOptions;
+    pluginOptions.threads = static_cast<unsigned int>(std::max(1, settings.value("plugins/threads", 2).toInt()));
+    pluginOptions.maxQueued = static_cast<size_t>(std::max(0, settings.value("plugins/maxQueued", 32).toInt()));
+    pluginOptions.defaultTimeoutMs = std::max(0, settings.value("plugins/timeoutMs", 5000).toInt());
+    plugins->configure(pluginOptions);
+    if (minCommandScore > 0.0) {
+        emit logMessage(QString("Порог оценки команд: %1 (%2)")
+                        .arg(minCommandScore, 0, 'f', 2)
+                        .arg(maxAlternatives > 0 ? QString("N-best из %1 вариантов").arg(maxAlternatives)
+                                                 : QString("conf слов")));
+    }
+
+    // Первая ступень каскада: грамматика из одной фразы активации
+    cascadeEnabled = settings.value("recognition/cascade", false).toBool();
+    cascadeActive = false;
+    if (cascadeEnabled) {
+        wakePhrase = foldedText(settings.value("recognition/wakePhrase", "ассистент").toString().toStdString());
+        cascadeTimeoutMs = std::max(500, settings.value("recognition/cascadeTimeoutMs", 5000).toInt());
+        std::string wakeGrammar = buildWakeGrammar();
+        if (!wakeGrammar.empty()) {
+            wakeRecognizer = vosk_recognizer_new_grm(model, SAMPLE_RATE, wakeGrammar.c_str());
+        }
+        if (wakeRecognizer) {
+            wakeHistory.configure(WAKE_HISTORY);
+            emit logMessage(QString("Каскадный режим: полное распознавание включается фразой \"%1\"")
+                            .arg(QString::fromStdString(wakePhrase)));
+        } else {
+            cascadeEnabled = false;
+            emit logMessage("Каскадный режим отключён: не удалось создать распознаватель фразы активации");
+        }
+    }
+
+    // Параметры захвата из настроек
+    CaptureOptions captureOptions;
+    captureOptions.device = settings.value("audio/device", "default").toString().toStdString();
+    captureOptions.mode = settings.value("audio/captureMode", "poll").toString() == "blocking"
+                              ? CaptureMode::Blocking : CaptureMode::Poll;
+    captureOptions.access = settings.value("audio/access", "mmap").toString() == "rw"
+                                ? CaptureAccess::ReadWrite : CaptureAccess::Mmap;
+    captureOptions.sampleRate = SAMPLE_RATE;
+    captureOptions.realtimePriority = settings.value("audio/realtimePriority", 0).toInt();
+    captureOptions.cpuCore = settings.value("audio/cpuCore", -1).toInt();
+
+    // Запускаем поток захвата аудио
+    if (!capture->start(captureOptions)) {
+        vosk_recognizer_free(recognizer);
+        recognizer = nullptr;
+        if (wakeRecognizer) {
+            vosk_recognizer_free(wakeRecognizer);
+            wakeRecognizer = nullptr;
+        }
+        releaseFanout();
+        ModelCache::instance().release(model);
+        model = nullptr;
+        emit statusChanged(false);
+        return;
+    }
+
+    // Распознаватель всегда получает 16 кГц моно, что бы ни выбрало устройство
+    maxChunkFrames = capture->frameSamples() / capture->channelCount() * 4;
+    resampler.configure(capture->sampleRate(), capture->channelCount(), SAMPLE_RATE, maxChunkFrames);
+    resampled.assign(resampler.maxOutput(maxChunkFrames), 0);
+    splitFrame.assign(capture->channelCount(), 0);
+    resampleNs = 0;
+    resampleInputFrames = 0;
+    if (!resampler.isPassthrough()) {
+        emit logMessage(QString("Включён ресемплинг %1 Гц, каналов %2 -> %3 Гц моно (%4)")
+                        .arg(capture->sampleRate()).arg(capture->channelCount())
+                        .arg(SAMPLE_RATE).arg(resampler.kernelName()));
+    }
+
+    // Детектор речи перед распознавателем
+    vadEnabled = settings.value("vad/enabled", true).toBool();
+    VadOptions vadOptions;
+    vadOptions.sampleRate = SAMPLE_RATE;
+    vadOptions.thresholdDb = settings.value("vad/thresholdDb", 9.0).toFloat();
+    vadOptions.hangoverMs = settings.value("vad/hangoverMs", 400).toUInt();
+    vad.configure(vadOptions);
+    unsigned int preRollMs = settings.value("vad/preRollMs", 300).toUInt();
+    preRoll.configure(static_cast<size_t>(SAMPLE_RATE) * preRollMs / 1000);
+
+    // Запуск команд по устойчивому частичному результату
+    earlyDispatch = settings.value("recognition/earlyDispatch", false).toBool();
+    if (earlyDispatch && minCommandScore > 0.0) {
+        // Порог оценки проверяется и для раннего запуска: частичным результатам нужны conf слов
+        vosk_recognizer_set_partial_words(recognizer, 1);
+    }
+    stablePartials = std::max(1, settings.value("recognition/stablePartials", 2).toInt());
+    resetPartialTracking();
+    earlyLatency = LatencyStats();
+    finalLatency = LatencyStats();
+
+    setupFanout(grammar);
+    startStreams(settings, grammar, vadOptions, preRollMs, captureOptions);
+
+    cascadeTriggers = 0;
+    std::fill(std::begin(stageCpuNs), std::end(stageCpuNs), 0);
+    std::fill(std::begin(stageWallNs), std::end(stageWallNs), 0);
+    stageCpuMark = threadCpuNs();
+    stageSince = std::chrono::steady_clock::now();
+
     running = true;
     emit statusChanged(true);
     emit logMessage("Голосовой ассистент запущен");
-    
-    // Запускаем обработку аудио
-    processTimer->start(100); // Обрабатываем каждые 100 мс
+
+    timings.totalMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startClock).count();
+    reportStartup();
+    emit modelReady();
+}
+
+void VoiceAssistantWorker::setupFanout(const std::string& grammar)
+{
+    if (fanoutConfigs.empty()) return;
+
+    fanout.reset(new RecognizerFanout);
+    int core = fanoutFirstCore;
+    for (const auto& config : fanoutConfigs) {
+        VoskRecognizer *branchRecognizer = nullptr;
+        if (config.grammar) {
+            std::string branchGrammar = grammar.empty() ? buildGrammar() : grammar;
+            branchRecognizer = vosk_recognizer_new_grm(model, SAMPLE_RATE, branchGrammar.c_str());
+        } else {
+            VoskModel *branchModel = model;
+            for (const auto& loaded : branchModels) {
+                if (loaded.first == config.name) {
+                    branchModel = loaded.second;
+                }
+            }
+            if (branchModel) {
+                branchRecognizer = vosk_recognizer_new(branchModel, SAMPLE_RATE);
+            }
+        }
+        if (!branchRecognizer) {
+            emit logMessage(QString("Ветвь %1 не создана: нет модели или распознавателя")
+                            .arg(QString::fromStdString(config.name)));
+            continue;
+        }
+
+        // conf слов нужен для выбора лучшей ветви
+        vosk_recognizer_set_words(branchRecognizer, 1);
+        fanout->addBranch(config.name, branchRecognizer, core, config.grammar);
+        if (core >= 0) {
+            ++core;
+        }
+    }
+
+    if (fanout->branchCount() == 0) {
+        fanout.reset();
+        return;
+    }
+
+    fanoutUtterance = 0;
+    fanoutPending = false;
+    fanout->start([this](const FanoutResult& result) {
+        QMetaObject::invokeMethod(this, [this, result]() {
+            onFanoutResult(result);
+        }, Qt::QueuedConnection);
+    }, fanoutMaxQueueMs);
+    emit logMessage(QString("Параллельных распознавателей: %1 (кроме основного)").arg(fanout->branchCount()));
+}
+
+void VoiceAssistantWorker::releaseFanout()
+{
+    fanoutTimer->stop();
+    fanoutPending = false;
+    if (fanout) {
+        fanout->stop();
+        for (const auto& branch : fanout->stats()) {
+            emit logMessage(QString("Ветвь %1: блоков %2, декодирование %3 мс, пик очереди %4, "
+                                    "пропущено блоков %5, итогов %6")
+                            .arg(QString::fromStdString(branch.name))
+                            .arg(static_cast<qint64>(branch.chunks))
+                            .arg(branch.decodeNs / 1e6, 0, 'f', 0)
+                            .arg(branch.peakQueue)
+                            .arg(static_cast<qint64>(branch.droppedBlocks))
+                            .arg(static_cast<qint64>(branch.droppedResults)));
+        }
+        fanout.reset();
+    }
+    for (const auto& branch : branchModels) {
+        ModelCache::instance().release(branch.second);
+    }
+    branchModels.clear();
+}
+
+void VoiceAssistantWorker::completeUtterance(const char* json_result)
+{
+    if (!fanout) {
+        handleResult(json_result);
+        return;
+    }
+
+    // Предыдущая фраза ещё ждёт отстающие ветви — решаем по тому, что уже есть
+    if (fanoutPending) {
+        decideFanout();
+    }
+
+    FanoutResult main;
+    main.utterance = ++fanoutUtterance;
+    main.branch = "main";
+    main.json = json_result;
+    double confidenceSum;
+    size_t words;
+    RecognizerFanout::parseResult(main.json, main.text, confidenceSum, words);
+    main.confidence = words ? confidenceSum / words : 0.0;
+
+    fanoutResults.clear();
+    fanoutResults.push_back(main);
+    fanoutPending = true;
+    fanout->finish(fanoutUtterance);
+    fanoutTimer->start(fanoutTimeoutMs);
+}
+
+void VoiceAssistantWorker::onFanoutResult(const FanoutResult& result)
+{
+    if (!fanoutPending || result.utterance != fanoutUtterance) return;
+    fanoutResults.push_back(result);
+    if (fanoutResults.size() == fanout->branchCount() + 1) {
+        decideFanout();
+    }
+}
+
+void VoiceAssistantWorker::decideFanout()
+{
+    if (!fanoutPending) return;
+    fanoutTimer->stop();
+    fanoutPending = false;
+
+    // Выигрывает больший средний conf слов. Наличие команды в тексте не учитывается: ветвь с грамматикой
+    // команд подгоняет под них любую речь. Итог передаётся как есть, со словами и conf, — команда
+    // из него проходит ту же оценку и порог minScore, что и у основного распознавателя
+    const FanoutResult *best = nullptr;
+    QStringList candidates;
+    for (const auto& result : fanoutResults) {
+        if (result.text.empty()) continue;
+        candidates << QString("%1 %2 \"%3\"")
+                      .arg(QString::fromStdString(result.branch))
+                      .arg(result.confidence, 0, 'f', 2)
+                      .arg(QString::fromStdString(result.text));
+        if (!best || result.confidence > best->confidence) {
+            best = &result;
+        }
+    }
+    if (!best) return;
+
+    if (candidates.size() > 1) {
+        emit logMessage(QString("Ветви: %1 -> выбрана %2")
+                        .arg(candidates.join(", "), QString::fromStdString(best->branch)));
+    }
+    handleResult(best->json.c_str());
+}
+
+void VoiceAssistantWorker::startStreams(QSettings& settings, const std::string& grammar, const VadOptions& vadOptions,
+                                        unsigned int preRollMs, const CaptureOptions& captureOptions)
+{
+    // [streams]: имя=alsa:<устройство> или имя=unix:<путь к сокету>, threads — размер пула
+    std::vector<StreamConfig> configs;
+    settings.beginGroup("streams");
+    for (const QString& key : settings.childKeys()) {
+        if (key == "threads") continue;
+        // Запятая в значении (hw:1,0) превращает его в список — собираем обратно
+        QString spec = settings.value(key).toStringList().join(",");
+        StreamConfig config;
+        if (StreamEngine::parseSource(key.toStdString(), spec.toStdString(), config)) {
+            configs.push_back(config);
+        } else {
+            emit logMessage(QString("Неверный источник потока %1: %2").arg(key, spec));
+        }
+    }
+    StreamEngineOptions options;
+    options.threads = settings.value("threads", 0).toUInt();
+    settings.endGroup();
+    if (configs.empty()) return;
+
+    options.grammar = grammar;
+    options.vadEnabled = vadEnabled;
+    options.vad = vadOptions;
+    options.preRollMs = preRollMs;
+    options.capture = captureOptions;
+    streamEngine->start(model, configs, options, [this](const std::string& stream, const char* json_result) {
+        return dispatchStreamResult(stream, json_result);
+    });
+}
+
+bool VoiceAssistantWorker::dispatchStreamResult(const std::string& stream, const char* json_result)
+{
+    // Команды выхода здесь не проверяются: остановить ассистента можно только с основного микрофона.
+    // Оценка та же, что у основного микрофона: conf слов, порог minScore, отказ без conf при пороге
+    static thread_local RecognitionResult parsed;
+    if (!ResultParser::parse(json_result, parsed)) return false;
+    std::vector<CommandIntent> intents;
+    {
+        std::lock_guard<std::mutex> lock(commandsMutex);
+        intents = scoreIntentsForResult(parsed);
+    }
+    // Из дополнительного потока по-прежнему выполняется одна команда на фразу — первая принятая
+    auto intent = std::find_if(intents.begin(), intents.end(), [](const CommandIntent& candidate) {
+        return !candidate.command.empty();
+    });
+    if (intent == intents.end()) return false;
+    if (!executeCommandScript(intent->command, stream, intent->slot_values)) return false;
+    emit logMessage(QString("[%1] Запущена команда: %2")
+                    .arg(QString::fromStdString(stream), QString::fromStdString(intent->command)));
+    return true;
+}
+
+void VoiceAssistantWorker::reportStartup()
+{
+    emit logMessage(QString("Время запуска: поиск модели %1 мс, загрузка модели %2 мс%3, "
+                            "распознаватель %4 мс, команды %5 мс, всего %6 мс")
+                    .arg(timings.pathDiscoveryMs, 0, 'f', 1)
+                    .arg(timings.modelLoadMs, 0, 'f', 1)
+                    .arg(timings.modelFromCache ? " (из кэша)" : "")
+                    .arg(timings.recognizerMs, 0, 'f', 1)
+                    .arg(timings.commandsMs, 0, 'f', 1)
+                    .arg(timings.totalMs, 0, 'f', 1));
+
+    if (!timings.modelFromCache) {
+        // Время загрузки с прогревом и без хранится раздельно, чтобы видеть разницу между запусками
+        QSettings settings("VoiceAssistant", "GUI");
+        settings.setValue(timings.prewarmed ? "startup/warmLoadMs" : "startup/coldLoadMs", timings.modelLoadMs);
+        double warmMs = settings.value("startup/warmLoadMs", -1.0).toDouble();
+        double coldMs = settings.value("startup/coldLoadMs", -1.0).toDouble();
+        if (warmMs >= 0.0 && coldMs >= 0.0) {
+            emit logMessage(QString("Загрузка модели: с прогревом %1 мс, без прогрева %2 мс (разница %3 мс)")
+                            .arg(warmMs, 0, 'f', 1)
+                            .arg(coldMs, 0, 'f', 1)
+                            .arg(coldMs - warmMs, 0, 'f', 1));
+        }
+    }
+
+    QJsonObject report;
+    report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["pathDiscoveryMs"] = timings.pathDiscoveryMs;
+    report["modelLoadMs"] = timings.modelLoadMs;
+    report["modelFromCache"] = timings.modelFromCache;
+    report["recognizerMs"] = timings.recognizerMs;
+    report["commandsMs"] = timings.commandsMs;
+    report["totalMs"] = timings.totalMs;
+    report["prewarmed"] = timings.prewarmed;
+    report["prewarmMs"] = timings.prewarmMs;
+    report["prewarmBytes"] = static_cast<double>(timings.prewarmBytes);
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Compact);
+
+    // Последний отчёт также сохраняется в файл для внешних инструментов
+    QString reportDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (QDir().mkpath(reportDir)) {
+        QFile reportFile(reportDir + "/startup-report.json");
+        if (reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            reportFile.write(json);
+            reportFile.close();
+        }
+    }
+
+    emit startupReport(QString::fromUtf8(json));
 }
 
 void VoiceAssistantWorker::stop()
 {
+    if (loading) {
+        // Загрузку прервать нельзя, но её результат будет отброшен
+        loading = false;
+        ++loadGeneration;
+        emit statusChanged(false);
+        emit logMessage("Загрузка модели отменена");
+        return;
+    }
     if (!running) return;
     
-    processTimer->stop();
+    capture->stop();
+    reloadTimer->stop();
+    if (!commandsWatcher->directories().isEmpty()) {
+        commandsWatcher->removePaths(commandsWatcher->directories());
+    }
+    if (!commandsWatcher->files().isEmpty()) {
+        commandsWatcher->removePaths(commandsWatcher->files());
+    }
     running = false;
     emit statusChanged(false);
     emit logMessage("Голосовой ассистент остановлен");
+    accountStage();
+    logCaptureStats();
+    // Потоки используют ту же модель — останавливаются до её освобождения
+    streamEngine->stop();
+    releaseFanout();
+    // Очередь скриптов отменяется; работающие скрипты завершаются вместе со своими дочерними процессами
+    executor->cancelAll(killOnStop);
+    // Работающий модуль прервать нельзя — он только видит cancelled
+    plugins->cancelAll(killOnStop);
     
     if (recognizer) {
         vosk_recognizer_free(recognizer);
         recognizer = nullptr;
     }
+    if (wakeRecognizer) {
+        vosk_recognizer_free(wakeRecognizer);
+        wakeRecognizer = nullptr;
+    }
     
     if (model) {
-        vosk_model_free(model);
+        ModelCache::instance().release(model);
         model = nullptr;
     }
 }
 
-void VoiceAssistantWorker::run()
+void VoiceAssistantWorker::onCaptureFailed()
 {
-    if (!running) return;
-    
-    static snd_pcm_t *capture_handle = nullptr;
-    static snd_pcm_hw_params_t *hw_params = nullptr;
-    static bool initialized = false;
-    static std::vector<short> buffer(BUFFER_SIZE);
-    
-    // Инициализация ALSA (один раз)
-    if (!initialized) {
-        int err;
-        
-        if ((err = snd_pcm_open(&capture_handle, "default", SND_PCM_STREAM_CAPTURE, 0)) < 0) {
-            emit logMessage(QString("Ошибка открытия аудио устройства: %1").arg(snd_strerror(err)));
-            return;
+    // Сигнал мог прийти после остановки и нового запуска — тогда захват уже работает
+    if (!running || capture->isRunning()) return;
+    emit logMessage("Захват звука прекращён из-за ошибки устройства, ассистент остановлен");
+    stop();
+}
+
+void VoiceAssistantWorker::releaseModel()
+{
+    // Модель, которую держит запущенный распознаватель, не выгружается
+    int freed = ModelCache::instance().purge();
+    ModelPrewarmer::instance().unlock();
+    emit logMessage(freed > 0 ? "Модель выгружена из памяти" : "Нет неиспользуемых моделей для выгрузки");
+}
+
+void VoiceAssistantWorker::processAudio()
+{
+    if (!running || !recognizer) return;
+
+    // Сначала разрешаем следующее уведомление, затем забираем всё накопленное,
+    // чтобы не потерять кадры, пришедшие во время разбора
+    capture->rearmNotification();
+
+    const size_t channels = resampler.inputChannels();
+    const short* samples = nullptr;
+    size_t count;
+    while (running && (count = capture->peek(&samples)) > 0) {
+        if (resampler.isPassthrough()) {
+            // Распознаватель читает кольцевой буфер на месте, без промежуточной копии
+            feedRecognizer(samples, count);
+            capture->consume(count);
+            continue;
         }
-        
-        snd_pcm_hw_params_alloca(&hw_params);
-        snd_pcm_hw_params_any(capture_handle, hw_params);
-        snd_pcm_hw_params_set_access(capture_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-        snd_pcm_hw_params_set_format(capture_handle, hw_params, SND_PCM_FORMAT_S16_LE);
-        snd_pcm_hw_params_set_rate_near(capture_handle, hw_params, (unsigned int[]){SAMPLE_RATE}, 0);
-        snd_pcm_hw_params_set_channels(capture_handle, hw_params, 1);
-        
-        if ((err = snd_pcm_hw_params(capture_handle, hw_params)) < 0) {
-            emit logMessage(QString("Ошибка настройки аудио параметров: %1").arg(snd_strerror(err)));
-            snd_pcm_close(capture_handle);
-            return;
+
+        size_t frames = std::min(count / channels, maxChunkFrames);
+        const bool split = (frames == 0);
+        if (split) {
+            // Кадр разорван концом кольцевого буфера — собираем его отдельно
+            size_t taken = 0;
+            while (taken < channels) {
+                const short* part = nullptr;
+                size_t n = std::min(capture->peek(&part), channels - taken);
+                std::copy(part, part + n, splitFrame.begin() + static_cast<std::ptrdiff_t>(taken));
+                capture->consume(n);
+                taken += n;
+            }
+            samples = splitFrame.data();
+            frames = 1;
         }
-        
-        initialized = true;
-        emit logMessage("Аудио устройство инициализировано");
-    }
-    
-    // Чтение аудио данных
-    snd_pcm_sframes_t frames = snd_pcm_readi(capture_handle, buffer.data(), BUFFER_SIZE/4);
-    if (frames < 0) {
-        frames = snd_pcm_recover(capture_handle, frames, 0);
-        if (frames < 0) {
-            emit logMessage(QString("Ошибка чтения аудио: %1").arg(snd_strerror(frames)));
-            return;
+
+        auto begin = std::chrono::steady_clock::now();
+        size_t produced = resampler.process(samples, frames, resampled.data());
+        resampleNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+        resampleInputFrames += frames;
+
+        if (!split) {
+            capture->consume(frames * channels);
         }
+        feedRecognizer(resampled.data(), produced);
     }
-    
-    if (frames > 0 && running && recognizer) {
-        const char* audio_data = reinterpret_cast<const char*>(buffer.data());
-        int audio_length = frames * sizeof(short);
-        
-        if (vosk_recognizer_accept_waveform(recognizer, audio_data, audio_length)) {
-            const char* result = vosk_recognizer_result(recognizer);
-            std::string json_result(result);
-            
-            // Извлекаем текст из JSON
-            std::string recognized_text = extractTextFromJson(json_result);
-            
-            if (!recognized_text.empty()) {
-                emit logMessage(QString("Распознано: %1").arg(QString::fromStdString(recognized_text)));
-                
-                // Проверяем команды выхода
-                std::string lower_text = recognized_text;
-                std::transform(lower_text.begin(), lower_text.end(), lower_text.begin(), ::tolower);
-                if (lower_text.find("выход") != std::string::npos || 
-                    lower_text.find("завершить") != std::string::npos) {
-                    emit logMessage("Команда выхода распознана");
-                    QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
-                    return;
-                }
-                
-                // Ищем подходящую команду
-                std::string command_name = findCommandForText(recognized_text);
-                
-                if (!command_name.empty()) {
-                    if (executeCommandScript(command_name)) {
-                        emit logMessage(QString("Выполнена команда: %1").arg(QString::fromStdString(command_name)));
-                    }
-                } else {
-                    emit logMessage("Команда не распознана");
-                }
+
+    checkCascadeTimeout();
+}
+
+void VoiceAssistantWorker::feedRecognizer(const short* samples, size_t count)
+{
+    if (!vadEnabled) {
+        acceptAudio(samples, count);
+        return;
+    }
+
+    // Тишина до распознавателя не доходит; конец речи завершает фразу сразу,
+    // не дожидаясь правил завершения по тишине из model.conf
+    for (size_t offset = 0; offset < count && running; offset += VAD_FRAME) {
+        size_t n = std::min<size_t>(VAD_FRAME, count - offset);
+        bool wasSpeech = vad.inSpeech();
+        switch (vad.process(samples + offset, n)) {
+        case VoiceActivityDetector::Speech:
+            if (!wasSpeech) {
+                replayPreRoll();
             }
+            acceptAudio(samples + offset, n);
+            break;
+        case VoiceActivityDetector::SpeechEnd:
+            acceptAudio(samples + offset, n);
+            finishUtterance();
+            break;
+        case VoiceActivityDetector::Silence:
+            preRoll.append(samples + offset, n);
+            break;
         }
     }
 }
 
-std::string VoiceAssistantWorker::extractTextFromJson(const std::string& json_result)
+void VoiceAssistantWorker::replayPreRoll()
 {
-    // Ищем "text" :
-    size_t text_pos = json_result.find("\"text\"");
-    if (text_pos != std::string::npos) {
-        size_t colon_pos = json_result.find(":", text_pos);
-        if (colon_pos != std::string::npos) {
-            size_t start_quote = json_result.find("\"", colon_pos);
-            if (start_quote != std::string::npos) {
-                size_t end_quote = json_result.find("\"", start_quote + 1);
-                if (end_quote != std::string::npos) {
-                    return json_result.substr(start_quote + 1, end_quote - start_quote - 1);
-                }
-            }
+    preRoll.forEachSpan([this](const short* data, size_t n) {
+        acceptAudio(data, n);
+    });
+    preRoll.clear();
+}
+
+void VoiceAssistantWorker::acceptAudio(const short* samples, size_t count)
+{
+    if (count == 0 || !recognizer) return;
+    if (cascadeEnabled && !cascadeActive) {
+        acceptWakeAudio(samples, count);
+        return;
+    }
+    if (fanout) {
+        fanout->push(samples, count);
+    }
+    if (vosk_recognizer_accept_waveform_s(recognizer, samples, static_cast<int>(count)) > 0) {
+        completeUtterance(vosk_recognizer_result(recognizer));
+    } else if (earlyDispatch) {
+        checkPartialResult();
+    }
+}
+
+void VoiceAssistantWorker::finishUtterance()
+{
+    if (cascadeEnabled && !cascadeActive) {
+        std::string text = resultText(vosk_recognizer_final_result(wakeRecognizer));
+        if (foldForMatch(text).find(wakePhrase) != std::string_view::npos) {
+            // Фраза активации прозвучала отдельно — команда будет следующей фразой
+            activateCascade(false);
         }
+        wakeHistory.clear();
+        return;
+    }
+    completeUtterance(vosk_recognizer_final_result(recognizer));
+}
+
+void VoiceAssistantWorker::acceptWakeAudio(const short* samples, size_t count)
+{
+    wakeHistory.append(samples, count);
+
+    bool final = vosk_recognizer_accept_waveform_s(wakeRecognizer, samples, static_cast<int>(count)) > 0;
+    std::string text = resultText(final ? vosk_recognizer_result(wakeRecognizer)
+                                        : vosk_recognizer_partial_result(wakeRecognizer));
+    if (foldForMatch(text).find(wakePhrase) != std::string_view::npos) {
+        // По частичному результату фраза ещё звучит: команда может идти следом без паузы,
+        // поэтому полный распознаватель получает её с начала
+        activateCascade(!final);
+    } else if (final) {
+        wakeHistory.clear();
+    }
+}
+
+void VoiceAssistantWorker::activateCascade(bool replayHistory)
+{
+    vosk_recognizer_reset(wakeRecognizer);
+    switchStage(true);
+    ++cascadeTriggers;
+    cascadeDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(cascadeTimeoutMs);
+    emit logMessage("Фраза активации распознана, включено полное распознавание");
+
+    if (replayHistory) {
+        wakeHistory.forEachSpan([this](const short* data, size_t n) {
+            acceptAudio(data, n);
+        });
+    }
+    wakeHistory.clear();
+}
+
+void VoiceAssistantWorker::checkCascadeTimeout()
+{
+    if (!cascadeEnabled || !cascadeActive || !running) return;
+    if (std::chrono::steady_clock::now() < cascadeDeadline) return;
+    // Фразу, которая ещё звучит, не обрываем
+    if (vadEnabled && vad.inSpeech()) return;
+
+    completeUtterance(vosk_recognizer_final_result(recognizer));
+    switchStage(false);
+    emit logMessage("Команд больше нет, ожидание фразы активации");
+}
+
+void VoiceAssistantWorker::switchStage(bool active)
+{
+    accountStage();
+    cascadeActive = active;
+}
+
+void VoiceAssistantWorker::accountStage()
+{
+    uint64_t cpu = threadCpuNs();
+    auto now = std::chrono::steady_clock::now();
+    int stage = currentStage();
+    stageCpuNs[stage] += cpu - stageCpuMark;
+    stageWallNs[stage] += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - stageSince).count());
+    stageCpuMark = cpu;
+    stageSince = now;
+}
+
+void VoiceAssistantWorker::handleResult(const char* result)
+{
+    // Состояние раннего запуска относится к завершившейся фразе — забираем и сбрасываем его
+    std::string early_command = earlyCommand;
+    bool timed = utteranceActive;
+    auto utterance_start = utteranceStart;
+    resetPartialTracking();
+
+    // Разбираем JSON один раз: текст, слова с conf и варианты N-best
+    static thread_local RecognitionResult parsed;
+    std::string recognized_text;
+    if (ResultParser::parse(result, parsed)) {
+        recognized_text = parsed.text.str();
+    }
+
+    if (!recognized_text.empty()) {
+        emit logMessage(QString("Распознано: %1").arg(QString::fromStdString(recognized_text)));
+
+        // Каждая распознанная фраза продлевает окно полного распознавания
+        if (cascadeActive) {
+            cascadeDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(cascadeTimeoutMs);
+        }
+
+        // Проверяем команды выхода
+        std::string_view lower_text = foldForMatch(recognized_text);
+        if (lower_text.find("выход") != std::string_view::npos ||
+            lower_text.find("завершить") != std::string_view::npos) {
+            emit logMessage("Команда выхода распознана");
+            QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+            return;
+        }
+
+        // Ищем команды фразы по всем вариантам и оцениваем их
+        std::vector<CommandIntent> intents = scoreIntentsForResult(parsed);
+        bool found = std::any_of(intents.begin(), intents.end(), [](const CommandIntent& intent) {
+            return !intent.command.empty();
+        });
+
+        if (found && timed) {
+            double latency = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - utterance_start).count();
+            finalLatency.add(latency);
+            emit logMessage(QString("Задержка по финальному результату: %1 мс").arg(latency, 0, 'f', 0));
+        }
+
+        if (!intents.empty() && !early_command.empty() && intents.front().command == early_command) {
+            emit logMessage(QString("Команда %1 уже выполнена по частичному результату")
+                            .arg(QString::fromStdString(early_command)));
+            intents.erase(intents.begin());
+        }
+        if (found) {
+            dispatchIntents(intents);
+        } else if (early_command.empty()) {
+            emit logMessage("Команда не распознана");
+        }
+    }
+}
+
+void VoiceAssistantWorker::checkPartialResult()
+{
+    const char* partial_json = vosk_recognizer_partial_result(recognizer);
+    std::string partial_text = resultText(partial_json);
+    if (partial_text.empty()) return;
+
+    if (!utteranceActive) {
+        utteranceActive = true;
+        utteranceStart = std::chrono::steady_clock::now();
+    }
+    // Команда этой фразы уже запущена
+    if (!earlyCommand.empty()) return;
+
+    // Частичный текст ещё меняется — по нему команда запускается только при точном совпадении
+    std::string command_name = findCommandForText(partial_text, false);
+    if (command_name.empty()) {
+        partialCommand.clear();
+        partialStreak = 0;
+        return;
+    }
+
+    if (command_name == partialCommand) {
+        ++partialStreak;
+    } else {
+        partialCommand = command_name;
+        partialStreak = 1;
+    }
+
+    // Совпадение должно продержаться stablePartials частичных результатов подряд
+    if (partialStreak < stablePartials) return;
+
+    // Оценка по conf слов частичного результата, как у финального. Ниже порога — ждём следующего
+    // частичного или финального результата; серия совпадений при этом сохраняется
+    if (minCommandScore > 0.0) {
+        static thread_local RecognitionResult parsed;
+        CommandScore scored[CommandScorer::MaxIntents];
+        if (!ResultParser::parse(partial_json, parsed)
+            || commandScorer.score(parsed, false, nullptr, scored) == 0
+            || commands[scored[0].hit.command].script_name != command_name
+            || !scored[0].measured || scored[0].score < minCommandScore) {
+            return;
+        }
+    }
+
+    earlyCommand = command_name;
+    double latency = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - utteranceStart).count();
+    earlyLatency.add(latency);
+    emit logMessage(QString("Ранний запуск по частичному результату \"%1\": %2 мс")
+                    .arg(QString::fromStdString(partial_text)).arg(latency, 0, 'f', 0));
+
+    if (executeCommandScript(command_name)) {
+        emit logMessage(QString("Запущена команда: %1").arg(QString::fromStdString(command_name)));
+    }
+}
+
+void VoiceAssistantWorker::resetPartialTracking()
+{
+    utteranceActive = false;
+    earlyCommand.clear();
+    partialCommand.clear();
+    partialStreak = 0;
+}
+
+void VoiceAssistantWorker::logCaptureStats()
+{
+    CaptureStats s = capture->stats();
+    double peakPercent = s.capacitySamples ? 100.0 * s.peakFillSamples / s.capacitySamples : 0.0;
+    emit logMessage(QString("Захват: кадров %1, потеряно (буфер полон) %2, переполнений ALSA %3, пиковое заполнение буфера %4%")
+                    .arg(static_cast<qint64>(s.framesCaptured))
+                    .arg(static_cast<qint64>(s.framesDropped))
+                    .arg(static_cast<qint64>(s.xruns))
+                    .arg(peakPercent, 0, 'f', 1));
+
+    if (!resampler.isPassthrough() && resampleInputFrames > 0) {
+        double audioSeconds = static_cast<double>(resampleInputFrames) / resampler.inputRate();
+        double msPerSecond = resampleNs / 1e6 / audioSeconds;
+        emit logMessage(QString("Ресемплинг (%1): %2 мс CPU на секунду аудио")
+                        .arg(resampler.kernelName())
+                        .arg(msPerSecond, 0, 'f', 3));
+    }
+
+    if (earlyLatency.count > 0 || finalLatency.count > 0) {
+        emit logMessage(QString("Задержка команд: по частичному результату %1 мс (n=%2), по финальному %3 мс (n=%4)")
+                        .arg(earlyLatency.average(), 0, 'f', 0).arg(static_cast<qint64>(earlyLatency.count))
+                        .arg(finalLatency.average(), 0, 'f', 0).arg(static_cast<qint64>(finalLatency.count)));
+    }
+
+    // Доля одного ядра, занятая потоком распознавания
+    auto cpuPercent = [this](int stage) {
+        return stageWallNs[stage] ? 100.0 * stageCpuNs[stage] / stageWallNs[stage] : 0.0;
+    };
+    if (cascadeEnabled) {
+        emit logMessage(QString("Каскад: срабатываний %1; ожидание активации %2% CPU за %3 с, "
+                                "полное распознавание %4% CPU за %5 с")
+                        .arg(static_cast<qint64>(cascadeTriggers))
+                        .arg(cpuPercent(0), 0, 'f', 2).arg(stageWallNs[0] / 1e9, 0, 'f', 0)
+                        .arg(cpuPercent(1), 0, 'f', 2).arg(stageWallNs[1] / 1e9, 0, 'f', 0));
+    } else if (stageWallNs[1] > 0) {
+        emit logMessage(QString("Распознавание: %1% CPU").arg(cpuPercent(1), 0, 'f', 2));
+    }
+
+    if (vadEnabled && vad.totalSamples() > 0) {
+        emit logMessage(QString("VAD: до распознавателя не допущено %1% аудио, фраз %2")
+                        .arg(vad.gatedFraction() * 100.0, 0, 'f', 1)
+                        .arg(static_cast<qint64>(vad.speechSegments())));
+    }
+
+    ExecutorStats e = executor->stats();
+    if (e.submitted > 0) {
+        emit logMessage(QString("Скрипты: запущено %1 (%2 через тёплые оболочки, перезапусков оболочек %3), "
+                                "успешно %4, с ошибкой %5, по таймауту %6, не запущено %7, отклонено (очередь полна) %8")
+                        .arg(static_cast<qint64>(e.spawned))
+                        .arg(static_cast<qint64>(e.warmLaunches))
+                        .arg(static_cast<qint64>(e.shellRestarts))
+                        .arg(static_cast<qint64>(e.succeeded))
+                        .arg(static_cast<qint64>(e.failed))
+                        .arg(static_cast<qint64>(e.timedOut))
+                        .arg(static_cast<qint64>(e.spawnFailed))
+                        .arg(static_cast<qint64>(e.rejected)));
+        emit logMessage(QString("Запуск скриптов: в среднем %1 мкс, максимум %2 мкс, ожидание в очереди до %3 мс")
+                        .arg(e.spawned ? e.spawnUsTotal / e.spawned : 0.0, 0, 'f', 0)
+                        .arg(e.spawnUsMax, 0, 'f', 0)
+                        .arg(e.queueMsMax, 0, 'f', 1));
+    }
+
+    PluginStats p = plugins->stats();
+    if (p.submitted > 0) {
+        emit logMessage(QString("Модули: выполнено %1, успешно %2, с ошибкой %3, по таймауту %4 "
+                                "(вернулись позже %5, занято потоков %6), отклонено (очередь полна) %7")
+                        .arg(static_cast<qint64>(p.executed))
+                        .arg(static_cast<qint64>(p.succeeded))
+                        .arg(static_cast<qint64>(p.failed))
+                        .arg(static_cast<qint64>(p.timedOut))
+                        .arg(static_cast<qint64>(p.lateReturns))
+                        .arg(p.stuckThreads)
+                        .arg(static_cast<qint64>(p.rejected)));
+        emit logMessage(QString("Выполнение модулей: в среднем %1 мкс, максимум %2 мкс, ожидание в очереди до %3 мкс")
+                        .arg(p.executed ? p.runUsTotal / p.executed : 0.0, 0, 'f', 0)
+                        .arg(p.runUsMax, 0, 'f', 0)
+                        .arg(p.queueUsMax, 0, 'f', 0));
     }
-    
-    return "";
 }
 
 bool VoiceAssistantWorker::fileExists(const std::string& path) {
@@ -286,46 +1235,71 @@ std::string VoiceAssistantWorker::getFileExtension(const std::string& filepath)
     return "";
 }
 
-std::vector<std::string> VoiceAssistantWorker::extractKeywordsFromScript(const std::string& script_path) {
-    std::vector<std::string> keywords;
+std::vector<std::string> VoiceAssistantWorker::extractKeywordsFromScript(const std::string& script_path, int& priority,
+                                                                        int& timeoutSec) {
+    priority = 0;
+    timeoutSec = -1;
     std::ifstream file(script_path);
     
     if (!file.is_open()) {
-        return keywords;
+        return std::vector<std::string>();
     }
     
+    std::vector<std::string> keywords = parseCommandHeader(file, priority, timeoutSec);
+    file.close();
+    return keywords;
+}
+
+std::vector<std::string> VoiceAssistantWorker::parseCommandHeader(std::istream& header, int& priority,
+                                                                 int& timeoutSec) {
+    std::vector<std::string> keywords;
+    priority = 0;
+    timeoutSec = -1;
+
     std::string line;
-    // Читаем первые несколько строк в поисках комментария с WORDS
-    for (int i = 0; i < 10 && std::getline(file, line); i++) {  // Проверяем первые 10 строк
+    // Читаем первые несколько строк в поисках комментариев с WORDS, PRIORITY и TIMEOUT
+    for (int i = 0; i < 10 && std::getline(header, line); i++) {  // Проверяем первые 10 строк
+        // Приоритет решает между командами с ключевыми словами одной длины
+        size_t priority_pos = line.find("# PRIORITY :");
+        if (priority_pos != std::string::npos) {
+            priority = std::atoi(line.c_str() + priority_pos + 12);
+            continue;
+        }
+
+        // Сколько секунд скрипт может работать, прежде чем его остановят
+        size_t timeout_pos = line.find("# TIMEOUT :");
+        if (timeout_pos != std::string::npos) {
+            timeoutSec = std::max(0, std::atoi(line.c_str() + timeout_pos + 11));
+            continue;
+        }
+
         // Ищем комментарий с WORDS
         size_t pos = line.find("# WORDS :");
-        if (pos != std::string::npos) {
+        if (pos != std::string::npos && keywords.empty()) {
             std::string keywords_line = line.substr(pos + 9);  // Пропускаем "# WORDS :"
             
             // Разделяем ключевые слова по запятым
             std::stringstream ss(keywords_line);
             std::string keyword;
             while (std::getline(ss, keyword, ',')) {
-                // Удаляем пробелы в начале и конце
-                keyword.erase(0, keyword.find_first_not_of(" \t"));
-                keyword.erase(keyword.find_last_not_of(" \t") + 1);
+                // Нижний регистр, ё → е, пробелы схлопнуты и обрезаны — как у распознанного текста
+                keyword = foldedText(keyword);
                 if (!keyword.empty()) {
-                    // Приводим к нижнему регистру
-                    std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::tolower);
                     keywords.push_back(keyword);
                 }
             }
-            break;
         }
     }
     
-    file.close();
     return keywords;
 }
 
 void VoiceAssistantWorker::loadCommands() 
 {
+    std::lock_guard<std::mutex> lock(commandsMutex);
     commands.clear();
+    commandMatcher.clear();
+    fuzzyMatcher.clear();
 
     // Определяем путь к директории команд и присваиваем значение переменной-члену класса
     if (QCoreApplication::applicationFilePath() == "/usr/local/bin/voice-assistant") {
@@ -348,27 +1322,78 @@ void VoiceAssistantWorker::loadCommands()
              emit logMessage(QString("Не удалось создать директорию %1").arg(QString::fromStdString(this->ComPath)));
              // Или так: emit logMessage("Не удалось создать директорию " + QString::fromStdString(this->ComPath));
         }
-        emit logMessage("Поместите сюда bash скрипты с ключевыми словами в комментариях");
+        emit logMessage("Поместите сюда bash скрипты с ключевыми словами в комментариях или команды-модули .so");
         return;
     }
 
     // Получаем список файлов в директории commands (std::string передается напрямую)
     std::vector<std::string> files = getFilesInDirectory(this->ComPath);
+    // При равной длине и приоритете совпадения выигрывает команда, загруженная раньше, — порядок не зависит от ФС
+    std::sort(files.begin(), files.end());
+
+    // Модули, которые остаются загруженными после перечитывания
+    std::vector<std::string> plugin_paths;
 
-    // Проходим по всем .sh файлам
+    // Проходим по всем .sh файлам и модулям .so
     for (const auto& filepath : files) {
         // Проверяем расширение файла (предполагается, что getFileExtension принимает std::string)
-        if (getFileExtension(filepath) == ".sh") {
+        const std::string extension = getFileExtension(filepath);
+        if (extension == ".sh" || extension == ".so") {
             // Получаем имя скрипта без расширения (предполагается, что getFilenameWithoutExtension принимает std::string)
             std::string script_name = getFilenameWithoutExtension(filepath);
-            // Извлекаем ключевые слова из скрипта (предполагается, что extractKeywordsFromScript принимает std::string)
-            std::vector<std::string> keywords = extractKeywordsFromScript(filepath);
-            if (!keywords.empty()) {
-                // Создаем структуру CommandInfo и заполняем её
-                CommandInfo cmd_info;
+            if (std::any_of(commands.begin(), commands.end(),
+                            [&script_name](const CommandInfo& cmd) { return cmd.script_name == script_name; })) {
+                emit logMessage(QString("Команда %1 уже загружена, %2 пропущен")
+                                .arg(QString::fromStdString(script_name), QString::fromStdString(filepath)));
+                continue;
+            }
+            int priority;
+            int timeoutSec;
+            std::vector<std::string> keywords;
+            std::shared_ptr<CommandPlugin> plugin;
+            if (extension == ".so") {
+                // Модуль описывает себя тем же заголовком, что и скрипт
+                std::string error;
+                plugin = plugins->load(filepath, error);
+                if (!plugin) {
+                    emit logMessage(QString("Модуль %1 не загружен: %2")
+                                    .arg(QString::fromStdString(filepath), QString::fromStdString(error)));
+                    continue;
+                }
+                plugin_paths.push_back(filepath);
+                std::istringstream header(plugin->header());
+                keywords = parseCommandHeader(header, priority, timeoutSec);
+            } else {
+                // Извлекаем ключевые слова из скрипта (предполагается, что extractKeywordsFromScript принимает std::string)
+                keywords = extractKeywordsFromScript(filepath, priority, timeoutSec);
+            }
+            // Шаблоны с параметрами ищутся по словам до первого параметра
+            CommandInfo cmd_info;
+            for (const auto& keyword : keywords) {
+                SlotPattern pattern;
+                std::string error;
+                if (!pattern.parse(keyword, error)) {
+                    emit logMessage(QString("Команда %1: шаблон \"%2\" пропущен: %3")
+                                    .arg(QString::fromStdString(script_name), QString::fromStdString(keyword),
+                                         QString::fromStdString(error)));
+                    continue;
+                }
+                if (std::find(cmd_info.keywords.begin(), cmd_info.keywords.end(), pattern.head()) == cmd_info.keywords.end()) {
+                    cmd_info.keywords.push_back(pattern.head());
+                }
+                cmd_info.patterns.push_back(pattern);
+            }
+            if (!cmd_info.keywords.empty()) {
+                // Заполняем остальные поля CommandInfo
                 cmd_info.script_name = script_name;
-                cmd_info.keywords = keywords;
+                cmd_info.priority = priority;
+                cmd_info.timeoutSec = timeoutSec;
+                cmd_info.plugin = plugin;
                 commands.push_back(cmd_info);
+                for (const auto& keyword : cmd_info.keywords) {
+                    commandMatcher.add(keyword, static_cast<int>(commands.size() - 1), priority);
+                    fuzzyMatcher.add(keyword, static_cast<int>(commands.size() - 1), priority);
+                }
 
                 // Формируем строку с ключевыми словами для лога
                 QString keywords_str;
@@ -377,45 +1402,395 @@ void VoiceAssistantWorker::loadCommands()
                     if (i < keywords.size() - 1) keywords_str += ", ";
                 }
                 // Логируем загруженную команду
-                emit logMessage(QString("Загружена команда: %1 (%2)")
+                emit logMessage(QString("Загружена команда: %1 (%2)%3")
                                .arg(QString::fromStdString(script_name))
-                               .arg(keywords_str));
+                               .arg(keywords_str)
+                               .arg(plugin ? QString(", модуль") : QString()));
             }
         }
     }
+    // Удалённые модули выгружаются, как только завершатся их вызовы
+    plugins->retainOnly(plugin_paths);
+
+    auto build_start = std::chrono::steady_clock::now();
+    commandMatcher.build();
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+    if (commandMatcher.keywordCount() > 0) {
+        emit logMessage(QString("Автомат ключевых слов: %1 фраз, %2 состояний, %3 классов байт, %4 КБ, построен за %5 мс")
+                        .arg(static_cast<qint64>(commandMatcher.keywordCount()))
+                        .arg(static_cast<qint64>(commandMatcher.stateCount()))
+                        .arg(static_cast<qint64>(commandMatcher.classCount()))
+                        .arg(static_cast<qint64>(commandMatcher.tableBytes() / 1024))
+                        .arg(build_ms, 0, 'f', 2));
+    }
+
+    if (fuzzyEnabled) {
+        build_start = std::chrono::steady_clock::now();
+        fuzzyMatcher.build(fuzzyThreshold);
+        build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+        if (fuzzyMatcher.keywordCount() > 0) {
+            emit logMessage(QString("Нечёткий поиск: %1 различных слов, %2 вариантов с удалениями, порог %3, построен за %4 мс")
+                            .arg(static_cast<qint64>(fuzzyMatcher.vocabularySize()))
+                            .arg(static_cast<qint64>(fuzzyMatcher.deletionCount()))
+                            .arg(fuzzyThreshold, 0, 'f', 2)
+                            .arg(build_ms, 0, 'f', 2));
+        }
+    }
 }
 
-std::string VoiceAssistantWorker::findCommandForText(const std::string& recognized_text) {
-    std::string lower_text = recognized_text;
-    std::transform(lower_text.begin(), lower_text.end(), lower_text.begin(), ::tolower);
-    
-    // Ищем совпадение по ключевым словам
+void VoiceAssistantWorker::watchCommands()
+{
+    if (!fileExists(this->ComPath)) return;
+
+    commandsWatcher->addPath(QString::fromStdString(this->ComPath));
+    for (const auto& filepath : getFilesInDirectory(this->ComPath)) {
+        const std::string extension = getFileExtension(filepath);
+        if (extension == ".sh" || extension == ".so") {
+            commandsWatcher->addPath(QString::fromStdString(filepath));
+        }
+    }
+}
+
+void VoiceAssistantWorker::onCommandsChanged()
+{
+    if (running) {
+        reloadTimer->start();
+    }
+}
+
+void VoiceAssistantWorker::reloadCommands()
+{
+    if (!running) return;
+
+    emit logMessage("Директория команд изменилась, перечитываю команды");
+    loadCommands();
+    // Новые файлы тоже должны отслеживаться (повторное добавление пути безвредно)
+    watchCommands();
+
+    if (grammarMode && recognizer) {
+        std::string grammar = buildGrammar();
+        vosk_recognizer_set_grm(recognizer, grammar.c_str());
+        emit logMessage("Грамматика распознавателя обновлена");
+    }
+    // Ветви и дополнительные потоки с грамматикой команд не должны узнавать удалённые команды
+    if (fanout) {
+        fanout->setGrammar(buildGrammar());
+    }
+    if (grammarMode && streamEngine->isRunning()) {
+        streamEngine->setGrammar(buildGrammar());
+    }
+}
+
+static std::string jsonEscape(const std::string& text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string VoiceAssistantWorker::buildGrammar()
+{
+    std::vector<std::string> phrases = {"выход", "завершить"};
+    // Слова шаблонов после параметров и, если нужны, числительные
+    bool numerals = false;
+    bool freeText = false;
     for (const auto& cmd : commands) {
-        for (const auto& keyword : cmd.keywords) {
-            if (lower_text.find(keyword) != std::string::npos) {
-                return cmd.script_name;
+        std::vector<std::string> keywords = cmd.keywords;
+        for (const auto& pattern : cmd.patterns) {
+            std::vector<std::string> literals = pattern.literalWords();
+            keywords.insert(keywords.end(), literals.begin(), literals.end());
+            numerals = numerals || pattern.uses(SlotType::Number) || pattern.uses(SlotType::Duration);
+            freeText = freeText || pattern.uses(SlotType::Text);
+        }
+        for (const auto& keyword : keywords) {
+            if (std::find(phrases.begin(), phrases.end(), keyword) != phrases.end()) {
+                continue;
             }
+
+            // Фраза со словом вне словаря модели сломает грамматику — пропускаем её
+            std::stringstream words(keyword);
+            std::string word;
+            bool known = true;
+            while (words >> word) {
+                if (vosk_model_find_word(model, word.c_str()) < 0) {
+                    emit logMessage(QString("Слово \"%1\" отсутствует в словаре модели, фраза \"%2\" пропущена")
+                                    .arg(QString::fromStdString(word), QString::fromStdString(keyword)));
+                    known = false;
+                    break;
+                }
+            }
+            if (known) {
+                phrases.push_back(keyword);
+            }
+        }
+    }
+    // Распознаватель с грамматикой собирает фразу из любых её элементов подряд: "громкость" + "пятьдесят"
+    if (numerals) {
+        for (const auto& word : NumeralParser::vocabulary()) {
+            if (vosk_model_find_word(model, word.c_str()) >= 0 &&
+                std::find(phrases.begin(), phrases.end(), word) == phrases.end()) {
+                phrases.push_back(word);
+            }
+        }
+    }
+    if (freeText) {
+        emit logMessage("Параметры {text} в режиме команд не распознаются: свободный текст не входит в грамматику");
+    }
+
+    // "[unk]" поглощает всё остальное, иначе любая речь будет подогнана под команду
+    std::string grammar = "[";
+    for (const auto& phrase : phrases) {
+        grammar += "\"" + jsonEscape(phrase) + "\", ";
+    }
+    grammar += "\"[unk]\"]";
+    return grammar;
+}
+
+std::string VoiceAssistantWorker::buildWakeGrammar()
+{
+    std::stringstream words(wakePhrase);
+    std::string word;
+    while (words >> word) {
+        if (vosk_model_find_word(model, word.c_str()) < 0) {
+            emit logMessage(QString("Слово \"%1\" фразы активации отсутствует в словаре модели")
+                            .arg(QString::fromStdString(word)));
+            return std::string();
         }
     }
+    return "[\"" + jsonEscape(wakePhrase) + "\", \"[unk]\"]";
+}
+
+std::string VoiceAssistantWorker::findCommandForText(const std::string& recognized_text, bool allowFuzzy,
+                                                     std::vector<SlotValue>* slot_values) {
+    std::string_view lower_text = foldForMatch(recognized_text);
     
-    return "";
+    // Один проход автомата по тексту: самое длинное ключевое слово, затем приоритет команды.
+    // Оговорки распознавателя ("браузера", "здраствуй") — по фонетическим кодам слов
+    CommandHit hit;
+    if (!commandScorer.match(lower_text, hit, allowFuzzy && fuzzyEnabled)) {
+        return "";
+    }
+    if (hit.fuzzy) {
+        emit logMessage(QString("Нечёткое совпадение: %1 (расстояние %2 на %3 звуков)")
+                        .arg(QString::fromStdString(commands[hit.command].script_name))
+                        .arg(hit.distance)
+                        .arg(static_cast<qint64>(hit.length)));
+    }
+    if (!resolveSlots(commands[hit.command], lower_text, hit, slot_values)) {
+        if (slot_values) {
+            emit logMessage(QString("Команда %1: параметры не распознаны")
+                            .arg(QString::fromStdString(commands[hit.command].script_name)));
+        }
+        return "";
+    }
+    return commands[hit.command].script_name;
+}
+
+std::vector<CommandIntent> VoiceAssistantWorker::scoreIntentsForResult(const RecognitionResult& result)
+{
+    std::vector<CommandIntent> intents;
+    CommandScore scored[CommandScorer::MaxIntents];
+    size_t count = commandScorer.score(result, fuzzyEnabled, multiCommand ? &segmenter : nullptr, scored);
+    if (count == 0) {
+        return intents;
+    }
+
+    // Параметры — из того варианта, по которому найдены команды, и только в пределах куска своей команды
+    const JsonString& source = scored[0].alternatives > 0 ? result.alternatives[scored[0].alternative].text
+                                                          : result.text;
+    std::string folded(foldForMatch(source.str()));
+
+    for (size_t k = 0; k < count; ++k) {
+        const CommandScore& intent = scored[k];
+        const CommandInfo& cmd = commands[intent.hit.command];
+        CommandIntent ready;
+        ready.sequential = intent.sequential;
+
+        QString details;
+        if (intent.alternatives > 0) {
+            details = QString("вариантов с командой %1 из %2").arg(intent.supporting).arg(intent.alternatives);
+        } else {
+            details = intent.measured ? QString("conf слов") : QString("без conf");
+        }
+        if (intent.hit.fuzzy) {
+            details += QString(", нечётко: расстояние %1 на %2 звуков")
+                       .arg(intent.hit.distance)
+                       .arg(static_cast<qint64>(intent.hit.length));
+        }
+
+        // Итог без conf и N-best оценить нечем: при заданном пороге такая команда не запускается
+        if (!intent.measured && minCommandScore > 0.0) {
+            emit logMessage(QString("Команда %1 отклонена: в результате нет conf слов, порог %2 не проверить")
+                            .arg(QString::fromStdString(cmd.script_name))
+                            .arg(minCommandScore, 0, 'f', 2));
+        } else if (intent.score < minCommandScore) {
+            emit logMessage(QString("Команда %1 отклонена: оценка %2 ниже порога %3 (%4)")
+                            .arg(QString::fromStdString(cmd.script_name))
+                            .arg(intent.score, 0, 'f', 2)
+                            .arg(minCommandScore, 0, 'f', 2)
+                            .arg(details));
+        } else if (!resolveSlots(cmd, std::string_view(folded).substr(0, intent.segmentEnd), intent.hit,
+                                 &ready.slot_values)) {
+            emit logMessage(QString("Команда %1: параметры не распознаны").arg(QString::fromStdString(cmd.script_name)));
+        } else {
+            emit logMessage(QString("Оценка команды %1: %2 (%3)")
+                            .arg(QString::fromStdString(cmd.script_name))
+                            .arg(intent.score, 0, 'f', 2)
+                            .arg(details));
+            ready.command = cmd.script_name;
+        }
+        intents.push_back(ready);
+    }
+
+    if (intents.size() > 1) {
+        QStringList order;
+        for (const auto& intent : intents) {
+            QString name = intent.command.empty() ? QString("(отклонена)") : QString::fromStdString(intent.command);
+            order << (order.isEmpty() ? name : (intent.sequential ? "затем " : "и ") + name);
+        }
+        emit logMessage(QString("Команд во фразе: %1: %2")
+                        .arg(static_cast<qint64>(intents.size()))
+                        .arg(order.join(", ")));
+    }
+    return intents;
+}
+
+void VoiceAssistantWorker::dispatchIntents(const std::vector<CommandIntent>& intents)
+{
+    if (intents.empty()) return;
+    dispatchGroup(std::make_shared<const std::vector<CommandIntent>>(intents), 0);
 }
 
-bool VoiceAssistantWorker::executeCommandScript(const std::string& command_name) {
-    std::string script_path = this->ComPath + "/" + command_name + ".sh";
+void VoiceAssistantWorker::dispatchGroup(std::shared_ptr<const std::vector<CommandIntent>> intents, size_t begin)
+{
+    // Группы независимых команд; зависимая команда ("потом", "затем") открывает следующую группу.
+    // Команды группы запускаются одновременно, следующая группа — из обратного вызова последнего
+    // завершившегося скрипта группы и только если все они выполнены. Никто не ждёт скрипты на месте
+    size_t end = begin + 1;
+    while (end < intents->size() && !(*intents)[end].sequential) {
+        ++end;
+    }
+
+    struct Group {
+        std::atomic<size_t> pending;
+        std::atomic<bool> failed;
+    };
+    auto group = std::make_shared<Group>();
+    group->pending = end - begin;
+    group->failed = false;
+
+    auto complete = [this, intents, group, end](bool succeeded) {
+        if (!succeeded) group->failed = true;
+        if (--group->pending > 0 || end == intents->size()) return;
+        if (!group->failed) {
+            dispatchGroup(intents, end);
+            return;
+        }
+        QStringList skipped;
+        for (size_t i = end; i < intents->size(); ++i) {
+            if (!(*intents)[i].command.empty()) {
+                skipped << QString::fromStdString((*intents)[i].command);
+            }
+        }
+        if (!skipped.isEmpty()) {
+            emit logMessage(QString("Не выполнены зависимые команды: %1 (предыдущая команда не выполнена)")
+                            .arg(skipped.join(", ")));
+        }
+    };
+
+    for (size_t i = begin; i < end; ++i) {
+        const CommandIntent& intent = (*intents)[i];
+        if (!intent.command.empty() &&
+            executeCommandScript(intent.command, std::string(), intent.slot_values, complete)) {
+            emit logMessage(QString("Запущена команда: %1").arg(QString::fromStdString(intent.command)));
+        } else {
+            complete(false);
+        }
+    }
+}
+
+bool VoiceAssistantWorker::executeCommandScript(const std::string& command_name, const std::string& stream,
+                                                const std::vector<SlotValue>& slot_values,
+                                                std::function<void(bool)> done) {
+    std::string script_path;
+    int timeoutSec = -1;
+    std::shared_ptr<CommandPlugin> plugin;
+    {
+        std::lock_guard<std::mutex> lock(commandsMutex);
+        script_path = this->ComPath + "/" + command_name + ".sh";
+        for (const auto& cmd : commands) {
+            if (cmd.script_name == command_name) {
+                timeoutSec = cmd.timeoutSec;
+                plugin = cmd.plugin;
+                break;
+            }
+        }
+    }
+
+    if (plugin) {
+        // Модуль выполняется в процессе ассистента, без fork и exec
+        emit logMessage(QString("Выполняю модуль: %1").arg(QString::fromStdString(plugin->path())));
+        PluginRequest request;
+        request.plugin = plugin;
+        request.command = command_name;
+        request.stream = stream;
+        request.slot_values = slot_values;
+        request.timeoutMs = timeoutSec < 0 ? -1 : timeoutSec * 1000;
+        request.done = done;
+        QStringList slot_log;
+        for (const auto& slot : slot_values) {
+            slot_log << QString::fromStdString(slot.name + "=" + slot.value);
+        }
+        if (!slot_log.isEmpty()) {
+            emit logMessage(QString("Параметры: %1").arg(slot_log.join(", ")));
+        }
+        if (!plugins->submit(std::move(request))) {
+            emit logMessage(QString("Модуль %1 не запущен: очередь модулей заполнена")
+                            .arg(QString::fromStdString(command_name)));
+            return false;
+        }
+        return true;
+    }
     
     if (fileExists(script_path)) {
         emit logMessage(QString("Выполняю скрипт: %1").arg(QString::fromStdString(script_path)));
-        
-        // Выполняем скрипт
-        int result = system(script_path.c_str());
-        if (result == 0) {
-            emit logMessage("Скрипт выполнен успешно");
-            return true;
-        } else {
-            emit logMessage("Ошибка выполнения скрипта");
+
+        ProcessRequest request;
+        request.path = script_path;
+        request.label = command_name;
+        request.timeoutMs = timeoutSec < 0 ? -1 : timeoutSec * 1000;
+        // Скрипт узнаёт, из какого потока пришла команда
+        if (!stream.empty()) {
+            request.environment.push_back("VOICE_ASSISTANT_STREAM=" + stream);
+        }
+        // Параметры — в переменных VOICE_ASSISTANT_SLOT_<ИМЯ> и аргументами в порядке шаблона
+        QStringList slot_log;
+        for (const auto& slot : slot_values) {
+            std::string name = slot.name;
+            std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+            request.environment.push_back("VOICE_ASSISTANT_SLOT_" + name + "=" + slot.value);
+            request.arguments.push_back(slot.value);
+            slot_log << QString::fromStdString(slot.name + "=" + slot.value);
+        }
+        if (!slot_log.isEmpty()) {
+            emit logMessage(QString("Параметры: %1").arg(slot_log.join(", ")));
+        }
+        if (done) {
+            request.done = [done](const ProcessResult& result) { done(result.succeeded()); };
+        }
+        // Только постановка в очередь: запуск, ожидание и таймаут — в потоке исполнителя
+        if (executor->submit(std::move(request)) == 0) {
+            emit logMessage(QString("Скрипт %1 не запущен: очередь скриптов заполнена")
+                            .arg(QString::fromStdString(command_name)));
             return false;
         }
+        return true;
     } else {
         emit logMessage(QString("Скрипт не найден: %1").arg(QString::fromStdString(script_path)));
         return false;
@@ -431,6 +1806,9 @@ VoiceAssistant::VoiceAssistant(QObject *parent)
     
     connect(worker, &VoiceAssistantWorker::logMessage, this, &VoiceAssistant::logMessage);
     connect(worker, &VoiceAssistantWorker::statusChanged, this, &VoiceAssistant::statusChanged);
+    connect(worker, &VoiceAssistantWorker::modelReady, this, &VoiceAssistant::modelReady);
+    connect(worker, &VoiceAssistantWorker::modelLoadFailed, this, &VoiceAssistant::modelLoadFailed);
+    connect(worker, &VoiceAssistantWorker::startupReport, this, &VoiceAssistant::startupReport);
     connect(workerThread, &QThread::finished, worker, &QObject::deleteLater);
     
     workerThread->start();
@@ -447,6 +1825,11 @@ bool VoiceAssistant::isRunning() const
     return worker->isRunning();
 }
 
+bool VoiceAssistant::isLoading() const
+{
+    return worker->isLoading();
+}
+
 void VoiceAssistant::start()
 {
     QMetaObject::invokeMethod(worker, "start", Qt::QueuedConnection);
@@ -456,3 +1839,8 @@ void VoiceAssistant::stop()
 {
     QMetaObject::invokeMethod(worker, "stop", Qt::QueuedConnection);
 }
+
+void VoiceAssistant::releaseModel()
+{
+    QMetaObject::invokeMethod(worker, "releaseModel", Qt::QueuedConnection);
+}
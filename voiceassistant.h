@@ -4,14 +4,85 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
+#include <QFileSystemWatcher>
+#include <QSettings>
 #include <alsa/asoundlib.h>
 #include "vosk_api.h"
+#include "audiocapture.h"
+#include "resampler.h"
+#include "vad.h"
+#include "prerollbuffer.h"
+#include "streamengine.h"
+#include "fanout.h"
+#include "keywordmatcher.h"
+#include "fuzzymatcher.h"
+#include "commandscorer.h"
+#include "slotpattern.h"
+#include "processexecutor.h"
+#include "pluginhost.h"
 #include <vector>
 #include <string>
+#include <iosfwd>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <condition_variable>
+#include <mutex>
 
 struct CommandInfo {
     std::string script_name;
-    std::vector<std::string> keywords;
+    std::vector<std::string> keywords;  // Слова для поиска команды (у шаблонов — начало до первого параметра)
+    std::vector<SlotPattern> patterns;  // Все ключевые слова из # WORDS, в том числе без параметров
+    int priority = 0;                   // # PRIORITY : — при совпадениях одной длины
+    int timeoutSec = -1;                // # TIMEOUT : — предел работы скрипта (-1 — commands/timeoutSec, 0 — без предела)
+    std::shared_ptr<CommandPlugin> plugin;  // Команда-модуль .so; nullptr — скрипт .sh
+};
+
+// Команда фразы, готовая к запуску
+struct CommandIntent {
+    std::string command;                // Пусто — команда найдена, но отклонена (оценка, параметры)
+    std::vector<SlotValue> slot_values;
+    bool sequential = false;            // Запускать после завершения предыдущих команд фразы
+};
+
+// Накопленная задержка от начала фразы до запуска команды
+struct LatencyStats {
+    uint64_t count = 0;
+    double totalMs = 0.0;
+
+    void add(double ms) { ++count; totalMs += ms; }
+    double average() const { return count ? totalMs / count : 0.0; }
+};
+
+// Время этапов запуска
+struct StartupTimings {
+    double pathDiscoveryMs = 0.0;
+    double modelLoadMs = 0.0;
+    bool modelFromCache = false;
+    double recognizerMs = 0.0;
+    double commandsMs = 0.0;
+    double totalMs = 0.0;
+    bool prewarmed = false;             // Файлы модели прогревались при старте приложения
+    double prewarmMs = 0.0;
+    uint64_t prewarmBytes = 0;
+};
+
+// Дополнительный распознаватель, получающий тот же звук, что и основной
+struct FanoutBranchConfig {
+    std::string name;
+    std::string modelPath;              // Своя модель (другой язык); пусто — основная модель
+    bool grammar = false;               // Грамматика из ключевых слов команд
+};
+
+// Результат фоновой загрузки модели
+struct ModelLoadResult {
+    std::string modelPath;
+    VoskModel *model = nullptr;
+    bool fromCache = false;
+    double pathDiscoveryMs = 0.0;
+    double modelLoadMs = 0.0;
+    std::vector<std::pair<std::string, VoskModel*>> branchModels;
 };
 
 class VoiceAssistantWorker : public QObject
@@ -23,36 +94,158 @@ public:
     ~VoiceAssistantWorker();
     
     bool isRunning() const { return running; }
+    bool isLoading() const { return loading; }
+    CaptureStats captureStats() const { return capture->stats(); }
 
 public slots:
     void start();
     void stop();
+    // Выгружает модели без ссылок; освобождение памяти модели занимает время, поэтому здесь, а не в потоке интерфейса
+    void releaseModel();
 
 signals:
     void logMessage(const QString& message);
     void statusChanged(bool running);
+    void modelReady();
+    void modelLoadFailed(const QString& error);
+    // Отчёт о времени запуска в JSON
+    void startupReport(const QString& json);
+
+private slots:
+    void processAudio();
+    void onCaptureFailed();
+    void onCommandsChanged();
+    void reloadCommands();
 
 private:
-    void run();
+    void finishStart(uint64_t generation, const ModelLoadResult& result);
+    void reportStartup();
+    void feedRecognizer(const short* samples, size_t count);
+    void acceptAudio(const short* samples, size_t count);
+    void replayPreRoll();
+    void acceptWakeAudio(const short* samples, size_t count);
+    void finishUtterance();
+    void activateCascade(bool replayHistory);
+    void checkCascadeTimeout();
+    void switchStage(bool active);
+    void accountStage();
+    int currentStage() const { return cascadeEnabled && !cascadeActive ? 0 : 1; }
+    void handleResult(const char* json_result);
+    void checkPartialResult();
+    void resetPartialTracking();
+    void logCaptureStats();
     void loadCommands();
-    std::string findCommandForText(const std::string& text);
-    bool executeCommandScript(const std::string& command_name);
-    std::vector<std::string> extractKeywordsFromScript(const std::string& script_path);
+    void watchCommands();
+    std::string buildGrammar();
+    std::string buildWakeGrammar();
+    // slot_values == nullptr — параметры не нужны (частичный результат): команды с шаблонами пропускаются
+    std::string findCommandForText(const std::string& text, bool allowFuzzy = true,
+                                   std::vector<SlotValue>* slot_values = nullptr);
+    std::vector<CommandIntent> scoreIntentsForResult(const RecognitionResult& result);
+    void dispatchIntents(const std::vector<CommandIntent>& intents);
+    void dispatchGroup(std::shared_ptr<const std::vector<CommandIntent>> intents, size_t begin);
+    // Ставит скрипт в очередь исполнителя (модуль — в очередь пула модулей) и сразу возвращается; done
+    // вызывается после завершения (в потоке исполнителя или пула) и только если команда принята — возвращено true
+    bool executeCommandScript(const std::string& command_name, const std::string& stream = std::string(),
+                              const std::vector<SlotValue>& slot_values = std::vector<SlotValue>(),
+                              std::function<void(bool)> done = nullptr);
+    bool dispatchStreamResult(const std::string& stream, const char* json_result);
+    void setupFanout(const std::string& grammar);
+    void releaseFanout();
+    void completeUtterance(const char* json_result);
+    void onFanoutResult(const FanoutResult& result);
+    void decideFanout();
+    void startStreams(QSettings& settings, const std::string& grammar, const VadOptions& vadOptions,
+                      unsigned int preRollMs, const CaptureOptions& captureOptions);
+    std::vector<std::string> extractKeywordsFromScript(const std::string& script_path, int& priority,
+                                                       int& timeoutSec);
+    // Комментарии # WORDS, # PRIORITY, # TIMEOUT в начале скрипта или заголовка модуля
+    std::vector<std::string> parseCommandHeader(std::istream& header, int& priority, int& timeoutSec);
     std::vector<std::string> getFilesInDirectory(const std::string& dir_path);
     std::string getFilenameWithoutExtension(const std::string& filepath);
     std::string getFileExtension(const std::string& filepath);
     bool fileExists(const std::string& path);
-    std::string extractTextFromJson(const std::string& json_result);
     
     // --- Объявление функции для поиска модели УДАЛЕНО из класса ---
     // std::string findModelPath(); // <--- Эта строка должна быть удалена
     // --- ---
 
-    bool running;
+    std::atomic<bool> running;
+    std::atomic<bool> loading;
+    uint64_t loadGeneration;            // Увеличивается при отмене, устаревший результат загрузки отбрасывается
+    int activeLoaders;
+    std::mutex loaderMutex;
+    std::condition_variable loaderDone;
+    std::chrono::steady_clock::time_point startClock;
+    StartupTimings timings;
     VoskModel *model;
     VoskRecognizer *recognizer;
     std::vector<CommandInfo> commands;
-    QTimer *processTimer;
+    KeywordMatcher commandMatcher;      // Ключевые слова commands, перестраивается в loadCommands()
+    FuzzyMatcher fuzzyMatcher;          // Нечёткий поиск, когда точного совпадения нет
+    bool fuzzyEnabled;
+    double fuzzyThreshold;              // Доля ошибочных звуков в слове
+    CommandScorer commandScorer;        // Оценка команд по N-best и conf слов
+    int maxAlternatives;                // Размер N-best основного распознавателя (0 — только лучший текст)
+    double minCommandScore;             // Команды с оценкой ниже не запускаются
+    bool multiCommand;                  // Несколько команд в одной фразе
+    UtteranceSegmenter segmenter;
+    std::mutex commandsMutex;           // commands и ComPath читаются также из потоков StreamEngine
+    AudioCapture *capture;
+    Resampler resampler;
+    std::vector<short> resampled;       // Выход ресемплера, выделяется при запуске
+    std::vector<short> splitFrame;      // Кадр, разорванный на границе кольцевого буфера
+    size_t maxChunkFrames;
+    uint64_t resampleNs;                // Время ресемплинга и объём обработанного звука для статистики
+    uint64_t resampleInputFrames;
+    VoiceActivityDetector vad;
+    bool vadEnabled;
+    PreRollBuffer preRoll;              // Звук перед открытием шлюза, проигрывается в начале фразы
+    bool grammarMode;                   // Распознаватель ограничен ключевыми словами команд
+    QFileSystemWatcher *commandsWatcher;
+    QTimer *reloadTimer;
+    StreamEngine *streamEngine;         // Дополнительные микрофоны и сокеты на той же модели
+    ProcessExecutor *executor;          // Скрипты команд: posix_spawn, очередь, таймауты
+    bool killOnStop;                    // Остановка ассистента завершает работающие скрипты
+    PluginHost *plugins;                // Команды-модули .so: в процессе, в своём пуле потоков
+
+    // Ранний запуск команд по частичным результатам
+    bool earlyDispatch;
+    int stablePartials;                 // Сколько частичных результатов подряд должна совпадать команда
+    std::string partialCommand;
+    int partialStreak;
+    std::string earlyCommand;           // Команда, уже запущенная в текущей фразе
+    bool utteranceActive;
+    std::chrono::steady_clock::time_point utteranceStart;
+    LatencyStats earlyLatency;
+    LatencyStats finalLatency;
+
+    // Каскад: постоянно работает дешёвый распознаватель фразы активации, полный — только после неё
+    bool cascadeEnabled;
+    bool cascadeActive;                 // Звук идёт в полный распознаватель
+    VoskRecognizer *wakeRecognizer;
+    std::string wakePhrase;
+    int cascadeTimeoutMs;
+    std::chrono::steady_clock::time_point cascadeDeadline;
+    PreRollBuffer wakeHistory;          // Звук первой ступени, проигрывается полному распознавателю при срабатывании
+    uint64_t cascadeTriggers;
+    // CPU потока распознавания и время по ступеням: 0 — ожидание активации, 1 — полное распознавание
+    uint64_t stageCpuNs[2];
+    uint64_t stageWallNs[2];
+    uint64_t stageCpuMark;
+    std::chrono::steady_clock::time_point stageSince;
+
+    // Параллельные распознаватели того же звука; побеждает итог с лучшим conf
+    std::vector<FanoutBranchConfig> fanoutConfigs;
+    std::vector<std::pair<std::string, VoskModel*>> branchModels;
+    std::unique_ptr<RecognizerFanout> fanout;
+    int fanoutTimeoutMs;
+    int fanoutFirstCore;
+    unsigned int fanoutMaxQueueMs;      // Сколько звука может ждать отстающая ветвь
+    uint64_t fanoutUtterance;
+    bool fanoutPending;
+    std::vector<FanoutResult> fanoutResults;
+    QTimer *fanoutTimer;                // Сколько ждать отстающие ветви
     std::string ComPath;
 };
 
@@ -69,14 +262,19 @@ public:
     ~VoiceAssistant();
 
     bool isRunning() const;
+    bool isLoading() const;
     
 public slots:
     void start();
     void stop();
+    void releaseModel();
 
 signals:
     void logMessage(const QString& message);
     void statusChanged(bool running);
+    void modelReady();
+    void modelLoadFailed(const QString& error);
+    void startupReport(const QString& json);
 
 private:
     QThread *workerThread;
@@ -0,0 +1,56 @@
+#ifndef VOICEASSISTANT_PLUGIN_H
+#define VOICEASSISTANT_PLUGIN_H
+
+// Команда-модуль: разделяемая библиотека .so в директории commands рядом со скриптами .sh.
+// Выполняется в процессе ассистента, в потоке пула модулей, без fork и exec — для быстрых действий
+// вроде уведомлений, громкости и вызовов D-Bus. Модуль собирается как C (или C++ с extern "C"):
+//     gcc -shared -fPIC -I<исходники ассистента> -o commands/имя.so имя.c
+// Пример — plugins/clock.c.
+
+#include <stddef.h>
+
+#define VA_PLUGIN_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Параметр команды из шаблона ключевого слова ("громкость {level:number}" → level = "50")
+typedef struct va_slot {
+    const char *name;
+    const char *value;
+} va_slot;
+
+// Вызов команды; все указатели действительны только до возврата из va_plugin_execute
+typedef struct va_call {
+    const char *command;                // Имя команды (имя файла без .so)
+    const char *stream;                 // Поток, из которого пришла команда; "" — основной микрофон
+    const va_slot *slot_values;         // Параметры в порядке шаблона
+    size_t slot_count;
+    void *host;                         // Для функций ниже
+    // Ненулевое значение — время вышло или ассистент остановлен, результат уже не нужен
+    int (*cancelled)(const struct va_call *call);
+    // Сообщение в журнал ассистента (UTF-8)
+    void (*log)(const struct va_call *call, const char *message);
+} va_call;
+
+// Вызывается после загрузки (и после загрузки изменившегося файла); 0 — модуль поддерживает abi_version и готов к работе
+int va_plugin_init(int abi_version);
+// Описание команды в формате заголовка скрипта: строки "# WORDS : ...", "# PRIORITY : ...", "# TIMEOUT : ...".
+// Строка принадлежит модулю и должна жить до его выгрузки
+const char *va_plugin_keywords(void);
+// Выполняет команду; 0 — успешно. Может вызываться из нескольких потоков одновременно
+int va_plugin_execute(const va_call *call);
+// Необязательная: вызывается перед выгрузкой модуля
+void va_plugin_shutdown(void);
+
+typedef int (*va_plugin_init_fn)(int abi_version);
+typedef const char *(*va_plugin_keywords_fn)(void);
+typedef int (*va_plugin_execute_fn)(const va_call *call);
+typedef void (*va_plugin_shutdown_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VOICEASSISTANT_PLUGIN_H